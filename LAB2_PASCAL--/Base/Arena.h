@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Непрерывный кусок массива в арене: указатель и длина
+template <typename T>
+struct Span {
+    T* items = nullptr;
+    uint32_t count = 0;
+
+    T* begin() const { return items; }
+    T* end() const { return items + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](size_t index) const { return items[index]; }
+};
+
+// Арена с выделением "сдвигом указателя". Объекты в ней не разрушаются по
+// одному: хранить можно только тривиально разрушаемые типы, а вся память
+// освобождается разом вместе с ареной (несколько крупных блоков).
+class Arena {
+private:
+    static constexpr size_t firstBlockSize = 4096;
+    static constexpr size_t maxBlockSize = 1 << 20;
+
+    vector<unique_ptr<char[]>> blocks;
+    char* current = nullptr;
+    size_t left = 0;
+    size_t nextBlockSize = firstBlockSize;
+    size_t reserved = 0;
+    size_t used = 0;
+
+    void addBlock(size_t minimum) {
+        size_t size = nextBlockSize;
+        while (size < minimum) {
+            size *= 2;
+        }
+        blocks.emplace_back(new char[size]);
+        current = blocks.back().get();
+        left = size;
+        reserved += size;
+        if (nextBlockSize < maxBlockSize) {
+            nextBlockSize *= 2;
+        }
+    }
+
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // блоки переходят к новой арене, а исходная становится пустой: иначе
+    // она продолжила бы выделять память в чужом блоке
+    Arena(Arena&& other) noexcept
+        : blocks(move(other.blocks)),
+          current(exchange(other.current, nullptr)),
+          left(exchange(other.left, 0)),
+          nextBlockSize(exchange(other.nextBlockSize, firstBlockSize)),
+          reserved(exchange(other.reserved, 0)),
+          used(exchange(other.used, 0)) {
+        other.blocks.clear();
+    }
+
+    Arena& operator=(Arena&& other) noexcept {
+        if (this != &other) {
+            blocks = move(other.blocks);
+            other.blocks.clear();
+            current = exchange(other.current, nullptr);
+            left = exchange(other.left, 0);
+            nextBlockSize = exchange(other.nextBlockSize, firstBlockSize);
+            reserved = exchange(other.reserved, 0);
+            used = exchange(other.used, 0);
+        }
+        return *this;
+    }
+
+    void* allocate(size_t size, size_t align) {
+        size_t padding = (align - reinterpret_cast<uintptr_t>(current) % align) % align;
+        if (padding + size > left) {
+            addBlock(size + align);
+            padding = (align - reinterpret_cast<uintptr_t>(current) % align) % align;
+        }
+        char* result = current + padding;
+        current = result + size;
+        left -= padding + size;
+        used += padding + size;
+        return result;
+    }
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(is_trivially_destructible_v<T>, "Arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T{ forward<Args>(args)... };
+    }
+
+    template <typename T>
+    Span<T> array(size_t count) {
+        static_assert(is_trivially_destructible_v<T>, "Arena objects are never destroyed");
+        Span<T> span;
+        if (count > 0) {
+            span.items = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+            for (size_t i = 0; i < count; i++) {
+                new (span.items + i) T();
+            }
+            span.count = uint32_t(count);
+        }
+        return span;
+    }
+
+    template <typename T>
+    Span<T> copy(const vector<T>& items) {
+        Span<T> span = array<T>(items.size());
+        for (size_t i = 0; i < items.size(); i++) {
+            span[i] = items[i];
+        }
+        return span;
+    }
+
+    // копия текста, живущая столько же, сколько арена
+    string_view copy(string_view text) {
+        if (text.empty()) {
+            return {};
+        }
+        char* chars = static_cast<char*>(allocate(text.size(), 1));
+        memcpy(chars, text.data(), text.size());
+        return string_view(chars, text.size());
+    }
+
+    // занято объектами (с выравниванием) и взято у системы
+    size_t bytesUsed() const { return used; }
+    size_t bytesReserved() const { return reserved; }
+};
@@ -15,17 +15,17 @@ using namespace std;
 class Node {
 public:
     enum class NodeType {
-        PROGRAM_STATEMENT,      //  
-        CONST_SECTION,          //   
-        VAR_SECTION,            //   
-        BEGIN_SECTION,          //    
-        CONST_DECLARATION,      //   
-        VARIABLE_DECLARATION,   //       
-        ASSIGNMENT_STATEMENT,   //  
-        IF_STATEMENT,           //  
-        WRITE_STATEMENT,        //   
-        READ_STATEMENT,         //  
-        IDENTIFIER_LIST         //  
+        PROGRAM_STATEMENT,      // заголовок программы
+        CONST_SECTION,          // блок объявления констант
+        VAR_SECTION,            // блок объявления переменных
+        BEGIN_SECTION,          // блок исполняемой части программы
+        CONST_DECLARATION,      // объявление одной константы
+        VARIABLE_DECLARATION,   // объявление одной или нескольких переменных одного типа
+        ASSIGNMENT_STATEMENT,   // оператор присваивания
+        IF_STATEMENT,           // условный оператор
+        WRITE_STATEMENT,        // оператор вывода 
+        READ_STATEMENT,         // оператор ввода
+        IDENTIFIER_LIST         // список идентификаторов
     };
 
     NodeType type;
@@ -37,27 +37,32 @@ public:
 
 class ProgramNode : public Node {
 public:
+    static constexpr NodeType kind = NodeType::PROGRAM_STATEMENT;
     string programName;
     ProgramNode(const string& name) : Node(NodeType::PROGRAM_STATEMENT), programName(name) {}
 };
 
 class ConstSectionNode : public Node {
 public:
+    static constexpr NodeType kind = NodeType::CONST_SECTION;
     ConstSectionNode() : Node(NodeType::CONST_SECTION) {}
 };
 
 class VarSectionNode : public Node {
 public:
+    static constexpr NodeType kind = NodeType::VAR_SECTION;
     VarSectionNode() : Node(NodeType::VAR_SECTION) {}
 };
 
 class BeginSectionNode : public Node {
 public:
+    static constexpr NodeType kind = NodeType::BEGIN_SECTION;
     BeginSectionNode() : Node(NodeType::BEGIN_SECTION) {}
 };
 
 class ConstDeclarationNode : public Node {
 public:
+    static constexpr NodeType kind = NodeType::CONST_DECLARATION;
     string identifier;
     string type;
     variant<int, double, string> value;
@@ -68,6 +73,7 @@ public:
 
 class IdentifierListNode : public Node {
 public:
+    static constexpr NodeType kind = NodeType::IDENTIFIER_LIST;
     list<string> identifiers;
     IdentifierListNode() : Node(NodeType::IDENTIFIER_LIST) {}
     IdentifierListNode(const list<string>& ids) : Node(NodeType::IDENTIFIER_LIST), identifiers(ids) {}
@@ -76,6 +82,7 @@ public:
 
 class VariableDeclarationNode : public Node {
 public:
+    static constexpr NodeType kind = NodeType::VARIABLE_DECLARATION;
     shared_ptr<Node> identifierList;
     string type;
     VariableDeclarationNode() : Node(NodeType::VARIABLE_DECLARATION) {}
@@ -85,6 +92,7 @@ public:
 
 class AssignmentStatementNode : public Node {
 public:
+    static constexpr NodeType kind = NodeType::ASSIGNMENT_STATEMENT;
     string variableName;
     vector<Token> expression;
     AssignmentStatementNode(const string& name) : Node(NodeType::ASSIGNMENT_STATEMENT), variableName(name) {}
@@ -95,6 +103,7 @@ public:
 
 class WriteStatementNode : public Node {
 public:
+    static constexpr NodeType kind = NodeType::WRITE_STATEMENT;
     vector<Token> expression;
     WriteStatementNode() : Node(NodeType::WRITE_STATEMENT) {}
     WriteStatementNode(const vector<Token>& expr) : Node(NodeType::WRITE_STATEMENT), expression(expr) {}
@@ -103,6 +112,7 @@ public:
 
 class ReadStatementNode : public Node {
 public:
+    static constexpr NodeType kind = NodeType::READ_STATEMENT;
     shared_ptr<Node> identifierList;
     ReadStatementNode() : Node(NodeType::READ_STATEMENT) {}
     ReadStatementNode(shared_ptr<Node> idList) : Node(NodeType::READ_STATEMENT), identifierList(idList) {}
@@ -110,6 +120,7 @@ public:
 
 class IfStatementNode : public Node {
 public:
+    static constexpr NodeType kind = NodeType::IF_STATEMENT;
     vector<Token> condition;
     list<shared_ptr<Node>> thenStatement;
     list<shared_ptr<Node>> elseStatement;
@@ -121,4 +132,17 @@ public:
             elseStatement = elseStmt.value();
         }
     }
-};
\ No newline at end of file
+};
+
+// Приведение по полю type вместо dynamic_cast: вид узла однозначно задаёт
+// его класс (поле kind). Возвращает nullptr, если узел другого вида;
+// shared_ptr не копируется.
+template <typename T>
+const T* nodeCast(const Node* node) {
+    return node && node->type == T::kind ? static_cast<const T*>(node) : nullptr;
+}
+
+template <typename T>
+const T* nodeCast(const shared_ptr<Node>& node) {
+    return nodeCast<T>(node.get());
+}
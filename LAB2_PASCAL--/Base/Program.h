@@ -0,0 +1,219 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <list>
+#include <memory>
+#include <variant>
+#include <stdexcept>
+#include "Arena.h"
+#include "Token.h"
+#include "Node.h"
+#include "Value.h"
+
+using namespace std;
+
+// Дерево программы в арене: узлы - тривиально разрушаемые структуры,
+// операторы блока лежат подряд в массиве Span, а всё дерево освобождается
+// вместе с ареной. Вид узла - тот же Node::NodeType, что и у Node.
+
+// номер ячейки у имени, которое ещё не связано с переменной
+constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+// Вхождение идентификатора; symbol - номер в SymbolTable лексера, если он
+// известен. Переменной Resolver назначает тип и slot - номер ячейки в
+// массиве значений этого типа (VariableStorage.h)
+struct Name {
+    string_view text;
+    uint32_t symbol = NO_SYMBOL;
+    uint32_t slot = NO_SLOT;
+    ValueType type = ValueType::INTEGER;
+};
+
+// переменная: имя, объявленный тип и ячейка в массиве этого типа
+struct VariableSlot {
+    string_view name;
+    ValueType type;
+    uint32_t slot;
+};
+
+// Узлы выражений. Скобки в дереве не хранятся - их задаёт его форма.
+enum class ExpressionKind : uint8_t {
+    LITERAL,
+    IDENTIFIER,
+    NEGATE,      // унарный минус
+    BINARY,      // + - * / div mod, операция - в op
+    COMPARISON   // = <> < > <= >=, только в условии if
+};
+
+struct CompiledExpression;
+
+struct Expr {
+    ExpressionKind kind;
+    TokenTypes op = TokenTypes::UNKNOWN;
+    ValueType type = ValueType::INTEGER;  // статический тип значения, его выводит Resolver
+    CompiledExpression* compiled = nullptr;  // у корня выражения, после первого исполнения
+};
+
+struct LiteralExpr : Expr {
+    Value value;
+};
+
+struct IdentifierExpr : Expr {
+    Name name;
+};
+
+struct UnaryExpr : Expr {
+    Expr* operand;
+};
+
+struct BinaryExpr : Expr {
+    Expr* left;
+    Expr* right;
+};
+
+// Лексемы выражений (tokens) сохраняются, только если дерево будет
+// переводиться в списки Node. Ошибка разбора выражения (error) выдаётся
+// при исполнении оператора, как и раньше.
+struct Statement {
+    Node::NodeType type;
+};
+
+struct ConstStatement : Statement {
+    Name name;
+    ValueType declared;
+    Value value;
+};
+
+struct VarStatement : Statement {
+    Span<Name> names;
+    ValueType declared;
+};
+
+struct AssignStatement : Statement {
+    Name target;
+    Expr* value = nullptr;
+    string_view error = {};
+    Span<TokenView> tokens = {};
+};
+
+struct WriteStatement : Statement {
+    Span<Expr*> arguments = {};
+    string_view error = {};
+    Span<TokenView> tokens = {};
+};
+
+struct ReadStatement : Statement {
+    Span<Name> targets;
+};
+
+struct IfStatement : Statement {
+    Expr* condition = nullptr;  // COMPARISON
+    string_view error = {};
+    Span<TokenView> tokens = {};
+    Span<Statement*> thenBranch = {};
+    Span<Statement*> elseBranch = {};
+    bool thenBlock = false;  // ветка записана как begin ... end
+    bool elseBlock = false;
+};
+
+inline vector<Token> toTokens(Span<TokenView> tokens) {
+    vector<Token> result;
+    result.reserve(tokens.size());
+    for (const TokenView& token : tokens) {
+        result.push_back(token.toToken());
+    }
+    return result;
+}
+
+class Program {
+private:
+    static shared_ptr<IdentifierListNode> identifiersOf(Span<Name> names) {
+        auto idList = make_shared<IdentifierListNode>();
+        for (const Name& name : names) {
+            idList->identifiers.push_back(string(name.text));
+        }
+        return idList;
+    }
+
+    static shared_ptr<Node> toNode(const Statement* statement) {
+        switch (statement->type) {
+        case Node::NodeType::CONST_DECLARATION: {
+            auto decl = static_cast<const ConstStatement*>(statement);
+            return make_shared<ConstDeclarationNode>(string(decl->name.text), typeName(decl->declared), decl->value.toVariant());
+        }
+        case Node::NodeType::VARIABLE_DECLARATION: {
+            auto decl = static_cast<const VarStatement*>(statement);
+            return make_shared<VariableDeclarationNode>(identifiersOf(decl->names), typeName(decl->declared));
+        }
+        case Node::NodeType::ASSIGNMENT_STATEMENT: {
+            auto assign = static_cast<const AssignStatement*>(statement);
+            return make_shared<AssignmentStatementNode>(string(assign->target.text), toTokens(assign->tokens));
+        }
+        case Node::NodeType::WRITE_STATEMENT:
+            return make_shared<WriteStatementNode>(toTokens(static_cast<const WriteStatement*>(statement)->tokens));
+        case Node::NodeType::READ_STATEMENT:
+            return make_shared<ReadStatementNode>(identifiersOf(static_cast<const ReadStatement*>(statement)->targets));
+        default: {
+            auto ifStatement = static_cast<const IfStatement*>(statement);
+            auto ifNode = make_shared<IfStatementNode>();
+            ifNode->condition = toTokens(ifStatement->tokens);
+            ifNode->thenStatement = toNodeBlock(ifStatement->thenBranch, ifStatement->thenBlock);
+            ifNode->elseStatement = toNodeBlock(ifStatement->elseBranch, ifStatement->elseBlock);
+            return ifNode;
+        }
+        }
+    }
+
+    static list<shared_ptr<Node>> toNodeBlock(Span<Statement*> statements, bool beginEnd) {
+        list<shared_ptr<Node>> block;
+        if (beginEnd) {
+            block.push_back(make_shared<BeginSectionNode>());
+        }
+        for (const Statement* statement : statements) {
+            block.push_back(toNode(statement));
+        }
+        return block;
+    }
+
+public:
+    Arena arena;
+    string_view name;
+    bool hasConstSection = false;
+    bool hasVarSection = false;
+    Span<Statement*> constSection;
+    Span<Statement*> varSection;
+    Span<Statement*> body;
+    Span<VariableSlot> variables;  // заполняет Resolver, в порядке объявления
+
+    Program() = default;
+    Program(Program&&) = default;
+    Program& operator=(Program&&) = default;
+
+    // лексема с текстом, скопированным в арену
+    TokenView copyToken(const Token& token) {
+        TokenView view(token.type, arena.copy(token.value), token.line, token.column);
+        view.symbol = token.symbol;
+        view.hash = token.hash;
+        view.number = token.number;
+        return view;
+    }
+
+    // то же дерево в виде списков Node, как его строил Parser::parse();
+    // у операторов без сохранённых лексем списки лексем будут пустыми
+    list<list<shared_ptr<Node>>> toNodes() const {
+        list<list<shared_ptr<Node>>> ast;
+        ast.push_back({ make_shared<ProgramNode>(string(name)) });
+        if (hasConstSection) {
+            ast.push_back(toNodeBlock(constSection, false));
+            ast.back().push_front(make_shared<ConstSectionNode>());
+        }
+        if (hasVarSection) {
+            ast.push_back(toNodeBlock(varSection, false));
+            ast.back().push_front(make_shared<VarSectionNode>());
+        }
+        ast.push_back(toNodeBlock(body, true));
+        return ast;
+    }
+};
@@ -0,0 +1,125 @@
+#include "SourceBuffer.h"
+
+// Чтение файла программы средствами ОС. Файл подключает одна единица
+// трансляции программы, которой нужен SourceBuffer::fromFile (как
+// PostfixConverter.cpp), поэтому windows.h не попадает в остальные.
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Файл, отображённый в память только для чтения: текст не копируется,
+// страницы берутся прямо из файлового кеша ОС
+class MappedSourceBuffer : public SourceBuffer {
+private:
+#if defined(_WIN32)
+    HANDLE mapping = nullptr;
+#endif
+    const char* view = nullptr;
+    size_t length = 0;
+
+public:
+#if defined(_WIN32)
+    MappedSourceBuffer(HANDLE file, size_t fileSize) : length(fileSize) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            view = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (!view) {
+            if (mapping) CloseHandle(mapping);
+            throw runtime_error("Error: Could not map source file into memory");
+        }
+        contents = string_view(view, length);
+    }
+
+    ~MappedSourceBuffer() override {
+        UnmapViewOfFile(view);
+        CloseHandle(mapping);
+    }
+#else
+    MappedSourceBuffer(int fd, size_t fileSize) : length(fileSize) {
+        void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            throw runtime_error("Error: Could not map source file into memory");
+        }
+        madvise(address, length, MADV_SEQUENTIAL);
+        view = static_cast<const char*>(address);
+        contents = string_view(view, length);
+    }
+
+    ~MappedSourceBuffer() override {
+        munmap(const_cast<char*>(view), length);
+    }
+#endif
+};
+
+// Обычный файл отображается в память, всё остальное (канал, устройство,
+// пустой файл) читается целиком в строку
+shared_ptr<const SourceBuffer> SourceBuffer::fromFile(const string& path) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw runtime_error("Error: Could not open source file " + path);
+    }
+    shared_ptr<const SourceBuffer> buffer;
+    LARGE_INTEGER fileSize;
+    try {
+        if (GetFileType(file) == FILE_TYPE_DISK && GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+            buffer = make_shared<const MappedSourceBuffer>(file, static_cast<size_t>(fileSize.QuadPart));
+        }
+        else {
+            string source;
+            char chunk[1 << 16];
+            DWORD bytesRead;
+            while (ReadFile(file, chunk, sizeof(chunk), &bytesRead, nullptr) && bytesRead > 0) {
+                source.append(chunk, bytesRead);
+            }
+            buffer = fromString(move(source));
+        }
+    }
+    catch (...) {
+        CloseHandle(file);
+        throw;
+    }
+    CloseHandle(file);
+    return buffer;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("Error: Could not open source file " + path);
+    }
+    shared_ptr<const SourceBuffer> buffer;
+    struct stat info;
+    try {
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            buffer = make_shared<const MappedSourceBuffer>(fd, static_cast<size_t>(info.st_size));
+        }
+        else {
+            string source;
+            char chunk[1 << 16];
+            ssize_t bytesRead;
+            while ((bytesRead = read(fd, chunk, sizeof(chunk))) > 0) {
+                source.append(chunk, static_cast<size_t>(bytesRead));
+            }
+            buffer = fromString(move(source));
+        }
+    }
+    catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd); // отображение остаётся действительным и после закрытия файла
+    return buffer;
+#endif
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <istream>
+#include <iterator>
+#include <stdexcept>
+
+using namespace std;
+
+// Текст программы, на который ссылаются лексемы TokenView.
+// Буфер неизменяем и живёт, пока на него есть хотя бы один shared_ptr.
+class SourceBuffer {
+protected:
+    string_view contents;
+
+    SourceBuffer() = default;
+
+public:
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+    virtual ~SourceBuffer() = default;
+
+    string_view text() const { return contents; }
+    size_t size() const { return contents.size(); }
+
+    static shared_ptr<const SourceBuffer> fromString(string source);
+    static shared_ptr<const SourceBuffer> fromStream(istream& input);
+    // определена в SourceBuffer.cpp: там же и вызовы ОС (windows.h, mmap),
+    // чтобы они не попадали в каждую единицу трансляции с лексемами
+    static shared_ptr<const SourceBuffer> fromFile(const string& path);
+};
+
+class StringSourceBuffer : public SourceBuffer {
+private:
+    string storage;
+
+public:
+    explicit StringSourceBuffer(string source) : storage(move(source)) {
+        contents = storage;
+    }
+};
+
+inline shared_ptr<const SourceBuffer> SourceBuffer::fromString(string source) {
+    return make_shared<const StringSourceBuffer>(move(source));
+}
+
+inline shared_ptr<const SourceBuffer> SourceBuffer::fromStream(istream& input) {
+    return fromString(string(istreambuf_iterator<char>(input), istreambuf_iterator<char>()));
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include "Token.h"
+
+using namespace std;
+
+// Таблица имён программы: каждому различному идентификатору выдаётся
+// плотный номер 0, 1, 2 ... в порядке первого появления. Хеш имени
+// считается один раз - при первом добавлении.
+class SymbolTable {
+private:
+    struct Symbol {
+        string_view name;
+        uint32_t hash;
+    };
+
+    deque<string> names;     // deque не перемещает строки, string_view на них не портятся
+    vector<Symbol> symbols;
+    vector<uint32_t> slots;  // открытая адресация: номер символа + 1, 0 - свободно
+
+    size_t slotOf(string_view name, uint32_t hash) const {
+        size_t mask = slots.size() - 1;
+        size_t slot = hash & mask;
+        while (slots[slot] != 0) {
+            const Symbol& symbol = symbols[slots[slot] - 1];
+            if (symbol.hash == hash && symbol.name == name) {
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    void grow() {
+        vector<uint32_t> previous(slots.empty() ? 16 : slots.size() * 2, 0);
+        previous.swap(slots);
+        for (uint32_t id = 0; id < symbols.size(); id++) {
+            slots[slotOf(symbols[id].name, symbols[id].hash)] = id + 1;
+        }
+    }
+
+public:
+    // FNV-1a
+    static constexpr uint32_t hashOf(string_view name) {
+        uint32_t hash = 2166136261u;
+        for (char c : name) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+        }
+        return hash;
+    }
+
+    uint32_t intern(string_view name, uint32_t hash) {
+        if ((symbols.size() + 1) * 2 > slots.size()) {
+            grow();
+        }
+        size_t slot = slotOf(name, hash);
+        if (slots[slot] == 0) {
+            names.emplace_back(name);
+            symbols.push_back({ names.back(), hash });
+            slots[slot] = uint32_t(symbols.size());
+        }
+        return slots[slot] - 1;
+    }
+
+    uint32_t intern(string_view name) {
+        return intern(name, hashOf(name));
+    }
+
+    // номер имени или NO_SYMBOL, если такого имени в таблице нет
+    uint32_t find(string_view name) const {
+        if (slots.empty()) {
+            return NO_SYMBOL;
+        }
+        size_t slot = slotOf(name, hashOf(name));
+        return slots[slot] == 0 ? NO_SYMBOL : slots[slot] - 1;
+    }
+
+    string_view name(uint32_t id) const { return symbols[id].name; }
+    uint32_t hash(uint32_t id) const { return symbols[id].hash; }
+    size_t size() const { return symbols.size(); }
+};
@@ -1,16 +1,20 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <cstdint>
+#include <charconv>
+#include <cmath>
 
 using namespace std;
 
 
 
 enum class TokenTypes {
-    IDENTIFIER,       //  
-    INTEGER_LITERAL,  //   int
-    DOUBLE_LITERAL,   //   double
-    STRING_LITERAL,   //   string
+    IDENTIFIER,       // имена переменных
+    INTEGER_LITERAL,  // переменная типа int
+    DOUBLE_LITERAL,   // переменная типа double
+    STRING_LITERAL,   // переменная типа string
     PLUS,             // '+'
     MINUS,            // '-'
     MULTIPLY,         // '*'
@@ -43,13 +47,61 @@ enum class TokenTypes {
     KEYWORD_DOUBLE,   // 'double'
     KEYWORD_STRING,   // 'string'
     END_OF_PROGRAM,   // 'end.'
-    UNKNOWN           //  
+    UNKNOWN           // неизвестный тип
 };
 
+// номер символа у лексем, которые не являются идентификаторами
+constexpr uint32_t NO_SYMBOL = UINT32_MAX;
+
+inline bool isNumericLiteral(TokenTypes type) {
+    return type == TokenTypes::INTEGER_LITERAL || type == TokenTypes::DOUBLE_LITERAL;
+}
+
+// Значение числового литерала; NaN, если текст не число, HUGE_VAL - при переполнении
+inline double parseNumericLiteral(string_view text) {
+    double number = NAN;
+    from_chars_result result = from_chars(text.data(), text.data() + text.size(), number);
+    if (result.ec == errc::result_out_of_range) {
+        return HUGE_VAL;
+    }
+    if (result.ec != errc() || result.ptr != text.data() + text.size()) {
+        return NAN;
+    }
+    return number;
+}
+
 struct Token {
     TokenTypes type;
     string value;
     int line;
     int column;
-    Token(TokenTypes tt = TokenTypes::UNKNOWN, string val = "", int l = -1, int c = -1) : type(tt), value(val), line(l), column(c) {}
+    uint32_t symbol = NO_SYMBOL; // номер идентификатора в SymbolTable лексера
+    uint32_t hash = 0;           // хеш имени идентификатора
+    double number = 0.0;         // значение числового литерала, разобранное один раз
+    Token(TokenTypes tt = TokenTypes::UNKNOWN, string val = "", int l = -1, int c = -1) : type(tt), value(move(val)), line(l), column(c) {
+        if (isNumericLiteral(type)) {
+            number = parseNumericLiteral(value);
+        }
+    }
+    // значение уже разобрано лексером
+    Token(TokenTypes tt, string val, int l, int c, double num) : type(tt), value(move(val)), line(l), column(c), number(num) {}
+};
+
+// Лексема без копирования текста: lexeme указывает в SourceBuffer лексера
+struct TokenView {
+    TokenTypes type;
+    string_view lexeme;
+    int line;
+    int column;
+    uint32_t symbol = NO_SYMBOL;
+    uint32_t hash = 0;
+    double number = 0.0;
+    TokenView(TokenTypes tt = TokenTypes::UNKNOWN, string_view lx = {}, int l = -1, int c = -1) : type(tt), lexeme(lx), line(l), column(c) {}
+
+    Token toToken() const {
+        Token token(type, string(lexeme), line, column, number);
+        token.symbol = symbol;
+        token.hash = hash;
+        return token;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <string_view>
+#include <algorithm>
+#include <stdexcept>
+#include "Token.h"
+#include "SourceBuffer.h"
+#include "SymbolTable.h"
+
+using namespace std;
+
+// Лексемы в виде параллельных массивов: тип (1 байт), смещение и длина
+// лексемы в SourceBuffer (по 4 байта). У идентификатора вместо длины
+// хранится его номер в SymbolTable, длина берётся из таблицы.
+// Строка и колонка не хранятся - они вычисляются по индексу начал строк,
+// который строится при первом запросе.
+class TokenBuffer {
+private:
+    shared_ptr<const SourceBuffer> source;
+    shared_ptr<const SymbolTable> symbolTable;
+    vector<uint8_t> types;
+    vector<uint32_t> offsets;
+    vector<uint32_t> lengths;
+    mutable vector<uint32_t> lineStarts;
+
+    // Переводы строк внутри строковых литералов лексер не считает,
+    // поэтому и здесь они пропускаются
+    void buildLineStarts() const {
+        string_view text = source->text();
+        lineStarts.push_back(0);
+        bool insideString = false;
+        for (size_t i = 0; i < text.size(); i++) {
+            if (text[i] == '"') {
+                insideString = !insideString;
+            }
+            else if (text[i] == '\n' && !insideString) {
+                lineStarts.push_back(uint32_t(i + 1));
+            }
+        }
+    }
+
+    // смещение первого символа лексемы в тексте (у строки - открывающей кавычки)
+    size_t startOffset(size_t index) const {
+        return types[index] == uint8_t(TokenTypes::STRING_LITERAL) ? offsets[index] - 1 : offsets[index];
+    }
+
+public:
+    TokenBuffer(shared_ptr<const SourceBuffer> sourceBuffer, shared_ptr<const SymbolTable> symbols)
+        : source(move(sourceBuffer)), symbolTable(move(symbols)) {
+        if (source->size() > UINT32_MAX) {
+            throw length_error("Error: Source is too large for a TokenBuffer");
+        }
+    }
+
+    void push(const TokenView& token) {
+        types.push_back(uint8_t(token.type));
+        offsets.push_back(uint32_t(token.lexeme.data() - source->text().data()));
+        lengths.push_back(token.type == TokenTypes::IDENTIFIER ? token.symbol : uint32_t(token.lexeme.size()));
+    }
+
+    void reserve(size_t count) {
+        types.reserve(count);
+        offsets.reserve(count);
+        lengths.reserve(count);
+    }
+
+    size_t size() const { return types.size(); }
+    bool empty() const { return types.empty(); }
+
+    TokenTypes type(size_t index) const { return TokenTypes(types[index]); }
+    uint32_t symbol(size_t index) const { return types[index] == uint8_t(TokenTypes::IDENTIFIER) ? lengths[index] : NO_SYMBOL; }
+    shared_ptr<const SymbolTable> symbols() const { return symbolTable; }
+
+    string_view lexeme(size_t index) const {
+        uint32_t id = symbol(index);
+        size_t length = id == NO_SYMBOL ? lengths[index] : symbolTable->name(id).size();
+        return source->text().substr(offsets[index], length);
+    }
+
+    shared_ptr<const SourceBuffer> sourceBuffer() const { return source; }
+
+    int line(size_t index) const {
+        if (lineStarts.empty()) {
+            buildLineStarts();
+        }
+        return int(upper_bound(lineStarts.begin(), lineStarts.end(), uint32_t(startOffset(index))) - lineStarts.begin());
+    }
+
+    int column(size_t index) const {
+        int lineNumber = line(index);
+        return int(startOffset(index) - lineStarts[lineNumber - 1]) + 1;
+    }
+
+    TokenView view(size_t index) const {
+        TokenView token(type(index), lexeme(index), line(index), column(index));
+        token.symbol = symbol(index);
+        if (token.symbol != NO_SYMBOL) {
+            token.hash = symbolTable->hash(token.symbol);
+        }
+        else if (isNumericLiteral(token.type)) {
+            token.number = parseNumericLiteral(token.lexeme);
+        }
+        return token;
+    }
+
+    Token token(size_t index) const {
+        return view(index).toToken();
+    }
+
+    // память под сами лексемы (без индекса строк и текста)
+    size_t bytes() const {
+        return types.capacity() * sizeof(uint8_t) + offsets.capacity() * sizeof(uint32_t) + lengths.capacity() * sizeof(uint32_t);
+    }
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <variant>
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+enum class ValueType : uint8_t {
+    INTEGER,
+    DOUBLE,
+    STRING
+};
+
+inline const char* typeName(ValueType type) {
+    switch (type) {
+    case ValueType::INTEGER: return "integer";
+    case ValueType::DOUBLE: return "double";
+    default: return "string";
+    }
+}
+
+inline bool parseTypeName(const string& name, ValueType& type) {
+    if (name == "integer") type = ValueType::INTEGER;
+    else if (name == "double") type = ValueType::DOUBLE;
+    else if (name == "string") type = ValueType::STRING;
+    else return false;
+    return true;
+}
+
+// Значение программы в 16 байтах: тип и объединение целого, вещественного
+// или ссылки на строку (указатель и длина). Строки значений неизменяемы и
+// лежат в арене Program, поэтому копия значения - копия 16 байт без выделения
+// памяти, а одинаковые ссылки (константа, подставленная Resolver в несколько
+// выражений) сравниваются без просмотра символов.
+class Value {
+private:
+    union {
+        int64_t integer;
+        double real;
+        const char* chars;
+    } data;
+    uint32_t length = 0;  // у строки
+    ValueType kind = ValueType::INTEGER;
+
+public:
+    Value() { data.integer = 0; }
+
+    static Value fromInteger(int64_t integer) {
+        Value value;
+        value.data.integer = integer;
+        return value;
+    }
+
+    static Value fromReal(double real) {
+        Value value;
+        value.kind = ValueType::DOUBLE;
+        value.data.real = real;
+        return value;
+    }
+
+    // text должен жить дольше значения - обычно это копия в арене
+    static Value fromText(string_view text) {
+        Value value;
+        value.kind = ValueType::STRING;
+        value.data.chars = text.data();
+        value.length = uint32_t(text.size());
+        return value;
+    }
+
+    ValueType type() const { return kind; }
+    int64_t integer() const { return data.integer; }
+    double real() const { return data.real; }
+    string_view text() const { return string_view(data.chars, length); }
+
+    // целое или вещественное значение числа - в double, как в арифметике
+    double number() const {
+        return kind == ValueType::INTEGER ? static_cast<double>(data.integer) : data.real;
+    }
+
+    variant<int, double, string> toVariant() const {
+        switch (kind) {
+        case ValueType::INTEGER: return static_cast<int>(data.integer);
+        case ValueType::DOUBLE: return data.real;
+        default: return string(text());
+        }
+    }
+
+    friend bool operator==(const Value& left, const Value& right) {
+        if (left.kind != right.kind)
+            return false;
+        switch (left.kind) {
+        case ValueType::INTEGER: return left.data.integer == right.data.integer;
+        case ValueType::DOUBLE: return left.data.real == right.data.real;
+        default:
+            return left.length == right.length &&
+                (left.length == 0 || left.data.chars == right.data.chars || memcmp(left.data.chars, right.data.chars, left.length) == 0);
+        }
+    }
+
+    friend bool operator!=(const Value& left, const Value& right) {
+        return !(left == right);
+    }
+};
+
+static_assert(sizeof(Value) == 16, "Value must stay 16 bytes");
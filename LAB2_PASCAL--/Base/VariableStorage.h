@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <variant>
+#include <cstdint>
+#include "Program.h"
+
+using namespace std;
+
+// Значения переменных программы: целые, вещественные и строковые - каждые
+// в своём сплошном массиве. Номер ячейки (Name::slot) - индекс в массиве
+// типа переменной, его назначает Resolver при объявлении, так что чтение
+// и запись не ищут имён и не проверяют, какой тип лежит в ячейке.
+struct VariableStorage {
+    vector<int> integers;
+    vector<double> reals;
+    vector<string> texts;
+
+    // у каждой объявленной переменной 0, 0.0 или ""
+    void reset(Span<VariableSlot> variables) {
+        integers.clear();
+        reals.clear();
+        texts.clear();
+        for (const VariableSlot& variable : variables) {
+            switch (variable.type) {
+            case ValueType::INTEGER: integers.push_back(0); break;
+            case ValueType::DOUBLE: reals.push_back(0.0); break;
+            default: texts.emplace_back(); break;
+            }
+        }
+    }
+
+    // значение ячейки одним вариантом - для отладки и встраивания
+    variant<int, double, string> value(ValueType type, uint32_t slot) const {
+        switch (type) {
+        case ValueType::INTEGER: return integers[slot];
+        case ValueType::DOUBLE: return reals[slot];
+        default: return texts[slot];
+        }
+    }
+};
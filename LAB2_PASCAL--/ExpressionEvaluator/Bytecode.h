@@ -0,0 +1,250 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+#include "../Base/Program.h"
+#include "IntegerArithmetic.h"
+
+using namespace std;
+
+// Байткод числового выражения: однобайтовые коды операций, за CONSTANT
+// следуют 8 байт double, за LOAD_* - 4 байта номера ячейки. Тип операнда
+// известен при компиляции, поэтому целая и вещественная ячейки читаются
+// разными кодами. Целые подвыражения считаются кодами INTEGER_* в int64
+// (за INTEGER_CONSTANT - 8 байт int64) и переводятся в double кодом
+// TO_DOUBLE, только когда встречаются с вещественным операндом. Ячейка
+// стека - 8 байт, double или int64 (IntegerArithmetic::load/store). Код
+// всегда заканчивается RETURN, глубина стека вычисляется при записи -
+// вычисление ничего не выделяет и не проверяет стек.
+enum class Opcode : uint8_t {
+    CONSTANT,
+    LOAD_INTEGER,
+    LOAD_DOUBLE,
+    NEGATE,
+    ADD,
+    SUBTRACT,
+    MULTIPLY,
+    DIVIDE,
+    DIV,
+    MOD,
+    INTEGER_CONSTANT,
+    INTEGER_LOAD,
+    INTEGER_NEGATE,
+    INTEGER_ADD,
+    INTEGER_SUBTRACT,
+    INTEGER_MULTIPLY,
+    INTEGER_DIV,
+    INTEGER_MOD,
+    TO_DOUBLE,
+    RETURN
+};
+
+class BytecodeWriter {
+private:
+    vector<uint8_t> code;
+    uint32_t depth = 0;
+    uint32_t maxDepth = 0;
+
+    template <typename T>
+    void operand(T value) {
+        size_t at = code.size();
+        code.resize(at + sizeof(T));
+        memcpy(code.data() + at, &value, sizeof(T));
+    }
+
+    void pushed() {
+        if (++depth > maxDepth) {
+            maxDepth = depth;
+        }
+    }
+
+public:
+    void reserve(size_t bytes) {
+        code.reserve(bytes);
+    }
+
+    void constant(double value) {
+        code.push_back(uint8_t(Opcode::CONSTANT));
+        operand(value);
+        pushed();
+    }
+
+    void load(ValueType type, uint32_t slot) {
+        code.push_back(uint8_t(type == ValueType::INTEGER ? Opcode::LOAD_INTEGER : Opcode::LOAD_DOUBLE));
+        operand(slot);
+        pushed();
+    }
+
+    void negate() {
+        code.push_back(uint8_t(Opcode::NEGATE));
+    }
+
+    void integerConstant(int64_t value) {
+        code.push_back(uint8_t(Opcode::INTEGER_CONSTANT));
+        operand(value);
+        pushed();
+    }
+
+    void integerLoad(uint32_t slot) {
+        code.push_back(uint8_t(Opcode::INTEGER_LOAD));
+        operand(slot);
+        pushed();
+    }
+
+    void integerNegate() {
+        code.push_back(uint8_t(Opcode::INTEGER_NEGATE));
+    }
+
+    void toDouble() {
+        code.push_back(uint8_t(Opcode::TO_DOUBLE));
+    }
+
+    void binary(Opcode opcode) {
+        code.push_back(uint8_t(opcode));
+        depth--;
+    }
+
+    static Opcode opcodeOf(TokenTypes op) {
+        switch (op) {
+        case TokenTypes::PLUS: return Opcode::ADD;
+        case TokenTypes::MINUS: return Opcode::SUBTRACT;
+        case TokenTypes::MULTIPLY: return Opcode::MULTIPLY;
+        case TokenTypes::DIVIDE: return Opcode::DIVIDE;
+        case TokenTypes::KEYWORD_DIV: return Opcode::DIV;
+        default: return Opcode::MOD;
+        }
+    }
+
+    static Opcode integerOpcodeOf(TokenTypes op) {
+        switch (op) {
+        case TokenTypes::PLUS: return Opcode::INTEGER_ADD;
+        case TokenTypes::MINUS: return Opcode::INTEGER_SUBTRACT;
+        case TokenTypes::MULTIPLY: return Opcode::INTEGER_MULTIPLY;
+        case TokenTypes::KEYWORD_DIV: return Opcode::INTEGER_DIV;
+        default: return Opcode::INTEGER_MOD;
+        }
+    }
+
+    // на стеке сейчас значений
+    uint32_t stackDepth() const { return depth; }
+    uint32_t maxStackDepth() const { return maxDepth; }
+
+    // дописывает RETURN и отдаёт код
+    vector<uint8_t> finish() {
+        code.push_back(uint8_t(Opcode::RETURN));
+        return move(code);
+    }
+};
+
+class Bytecode {
+private:
+    template <typename T>
+    static T read(const uint8_t*& code) {
+        T value;
+        memcpy(&value, code, sizeof(T));
+        code += sizeof(T);
+        return value;
+    }
+
+    // целая операция над двумя верхними ячейками
+    template <typename Operation>
+    static void integer(double*& top, Operation operation) {
+        top--;
+        IntegerArithmetic::store(top - 1, operation(IntegerArithmetic::load(top - 1), IntegerArithmetic::load(top)));
+    }
+
+    // исполняет код и возвращает ячейку с результатом
+    template <typename Operands>
+    static double* execute(const uint8_t* code, const Operands& operands, double* stack) {
+        double* top = stack;
+        for (;;) {
+            switch (Opcode(*code++)) {
+            case Opcode::CONSTANT:
+                *top++ = read<double>(code);
+                break;
+            case Opcode::LOAD_INTEGER:
+                *top++ = operands.integer(read<uint32_t>(code));
+                break;
+            case Opcode::LOAD_DOUBLE:
+                *top++ = operands.real(read<uint32_t>(code));
+                break;
+            case Opcode::NEGATE:
+                top[-1] = -top[-1];
+                break;
+            case Opcode::ADD:
+                top--;
+                top[-1] += *top;
+                break;
+            case Opcode::SUBTRACT:
+                top--;
+                top[-1] -= *top;
+                break;
+            case Opcode::MULTIPLY:
+                top--;
+                top[-1] *= *top;
+                break;
+            case Opcode::DIVIDE:
+                top--;
+                if (*top == 0.0) throw runtime_error("Division by zero");
+                top[-1] /= *top;
+                break;
+            case Opcode::DIV:
+                top--;
+                if (*top == 0.0) throw runtime_error("Integer division by zero");
+                top[-1] = floor(top[-1] / *top);
+                break;
+            case Opcode::MOD:
+                top--;
+                if (*top == 0.0) throw runtime_error("Modulo by zero");
+                top[-1] = fmod(top[-1], *top);
+                break;
+            case Opcode::INTEGER_CONSTANT:
+                IntegerArithmetic::store(top++, read<int64_t>(code));
+                break;
+            case Opcode::INTEGER_LOAD:
+                IntegerArithmetic::store(top++, operands.integer(read<uint32_t>(code)));
+                break;
+            case Opcode::INTEGER_NEGATE:
+                IntegerArithmetic::store(top - 1, IntegerArithmetic::negate(IntegerArithmetic::load(top - 1)));
+                break;
+            case Opcode::INTEGER_ADD:
+                integer(top, IntegerArithmetic::add);
+                break;
+            case Opcode::INTEGER_SUBTRACT:
+                integer(top, IntegerArithmetic::subtract);
+                break;
+            case Opcode::INTEGER_MULTIPLY:
+                integer(top, IntegerArithmetic::multiply);
+                break;
+            case Opcode::INTEGER_DIV:
+                integer(top, IntegerArithmetic::div);
+                break;
+            case Opcode::INTEGER_MOD:
+                integer(top, IntegerArithmetic::mod);
+                break;
+            case Opcode::TO_DOUBLE:
+                top[-1] = static_cast<double>(IntegerArithmetic::load(top - 1));
+                break;
+            case Opcode::RETURN:
+                return top - 1;
+            }
+        }
+    }
+
+public:
+    // Operands - источник значений ячеек с методами integer(slot) и real(slot);
+    // stack - не меньше maxStackDepth() значений. run - для кода с
+    // вещественным результатом, runInteger - для кода целого выражения
+    template <typename Operands>
+    static double run(const uint8_t* code, const Operands& operands, double* stack) {
+        return *execute(code, operands, stack);
+    }
+
+    template <typename Operands>
+    static int64_t runInteger(const uint8_t* code, const Operands& operands, double* stack) {
+        return IntegerArithmetic::load(execute(code, operands, stack));
+    }
+};
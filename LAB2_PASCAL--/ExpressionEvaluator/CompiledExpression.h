@@ -0,0 +1,123 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "../Base/Arena.h"
+#include "../Base/Program.h"
+#include "Bytecode.h"
+
+using namespace std;
+
+// Скомпилированное выражение: операнды уже связаны с ячейками (или
+// подставлены константами), скобок и имён нет. Строится один раз для корня
+// выражения и хранится на его узле (Expr::compiled), так что повторные
+// исполнения оператора и повторные Interpreter::run его не пересобирают.
+
+// часть строкового выражения: текст константы или ячейка (slot != NO_SLOT)
+struct StringPart {
+    uint32_t slot;
+    string_view text;
+};
+
+// Числовое выражение - байткод (Bytecode.h) и глубина его стека; код
+// целого выражения (type INTEGER) оставляет результат в int64. У
+// строкового все операции - '+', поэтому оно - просто части строки подряд.
+struct CompiledExpression {
+    ValueType type;
+    uint32_t depth;
+    Span<uint8_t> code;
+    Span<StringPart> parts;
+};
+
+class ExpressionCompiler {
+private:
+    BytecodeWriter writer;
+    vector<StringPart> parts;
+
+    // целое выражение целиком в int64
+    void emitInteger(const Expr* expression) {
+        switch (expression->kind) {
+        case ExpressionKind::LITERAL:
+            writer.integerConstant(static_cast<const LiteralExpr*>(expression)->value.integer());
+            break;
+        case ExpressionKind::IDENTIFIER:
+            writer.integerLoad(static_cast<const IdentifierExpr*>(expression)->name.slot);
+            break;
+        case ExpressionKind::NEGATE:
+            emitInteger(static_cast<const UnaryExpr*>(expression)->operand);
+            writer.integerNegate();
+            break;
+        default: {
+            const auto binary = static_cast<const BinaryExpr*>(expression);
+            emitInteger(binary->left);
+            emitInteger(binary->right);
+            writer.binary(BytecodeWriter::integerOpcodeOf(binary->op));
+            break;
+        }
+        }
+    }
+
+    // вещественное выражение: целые подвыражения считаются в int64 и
+    // переводятся в double, целые литералы и ячейки читаются сразу как double
+    void emitNumber(const Expr* expression) {
+        if (expression->type == ValueType::INTEGER && expression->kind != ExpressionKind::LITERAL && expression->kind != ExpressionKind::IDENTIFIER) {
+            emitInteger(expression);
+            writer.toDouble();
+            return;
+        }
+        switch (expression->kind) {
+        case ExpressionKind::LITERAL:
+            writer.constant(static_cast<const LiteralExpr*>(expression)->value.number());
+            break;
+        case ExpressionKind::IDENTIFIER:
+            writer.load(expression->type, static_cast<const IdentifierExpr*>(expression)->name.slot);
+            break;
+        case ExpressionKind::NEGATE:
+            emitNumber(static_cast<const UnaryExpr*>(expression)->operand);
+            writer.negate();
+            break;
+        default: {
+            const auto binary = static_cast<const BinaryExpr*>(expression);
+            emitNumber(binary->left);
+            emitNumber(binary->right);
+            writer.binary(BytecodeWriter::opcodeOf(binary->op));
+            break;
+        }
+        }
+    }
+
+    void emitString(const Expr* expression) {
+        switch (expression->kind) {
+        case ExpressionKind::LITERAL:
+            parts.push_back(StringPart{ NO_SLOT, static_cast<const LiteralExpr*>(expression)->value.text() });
+            break;
+        case ExpressionKind::IDENTIFIER:
+            parts.push_back(StringPart{ static_cast<const IdentifierExpr*>(expression)->name.slot, {} });
+            break;
+        default: {
+            const auto binary = static_cast<const BinaryExpr*>(expression);
+            emitString(binary->left);
+            emitString(binary->right);
+            break;
+        }
+        }
+    }
+
+public:
+    // expression должно быть проверено Resolver
+    static CompiledExpression* compile(Arena& arena, const Expr* expression) {
+        ExpressionCompiler compiler;
+        if (expression->type == ValueType::STRING) {
+            compiler.emitString(expression);
+            return arena.make<CompiledExpression>(expression->type, 0u, Span<uint8_t>(), arena.copy(compiler.parts));
+        }
+        if (expression->type == ValueType::INTEGER)
+            compiler.emitInteger(expression);
+        else
+            compiler.emitNumber(expression);
+        uint32_t depth = compiler.writer.maxStackDepth();
+        return arena.make<CompiledExpression>(expression->type, depth, arena.copy(compiler.writer.finish()), Span<StringPart>());
+    }
+};
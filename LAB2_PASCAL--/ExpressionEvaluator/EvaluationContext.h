@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "../Base/VariableStorage.h"
+
+using namespace std;
+
+// Окружение вычисления выражений: ссылка на ячейки переменных интерпретатора.
+// Ничего не копирует и живёт столько же, сколько ячейки; операнды берутся
+// по типу и номеру ячейки, которые назначил Resolver, так что цена вычисления
+// зависит только от размера выражения, а не от числа переменных.
+class EvaluationContext {
+private:
+    const VariableStorage* storage = nullptr;
+
+public:
+    EvaluationContext() = default;
+    explicit EvaluationContext(const VariableStorage& values) : storage(&values) {}
+
+    int integer(uint32_t slot) const {
+        return storage->integers[slot];
+    }
+
+    double real(uint32_t slot) const {
+        return storage->reals[slot];
+    }
+
+    const string& text(uint32_t slot) const {
+        return storage->texts[slot];
+    }
+};
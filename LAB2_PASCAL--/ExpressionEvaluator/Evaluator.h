@@ -4,6 +4,9 @@
 #include <string>
 #include "../Base/Node.h"
 #include "../Base/Token.h"
+#include "../Base/Program.h"
+#include "EvaluationContext.h"
+#include "CompiledExpression.h"
 #include "Expression.h"
 #include <unordered_map>
 #include <map>
@@ -13,20 +16,20 @@ class Evaluator
 {
 public:
 
-	static double evaluate_numeric(vector<Token> expression, unordered_map<string, variant<int, double, string>> variables, unordered_map<string, variant<int, double, string>> constants)
+	static double evaluate_numeric(const vector<Token>& expression, const unordered_map<string, variant<int, double, string>>& variables, const unordered_map<string, variant<int, double, string>>& constants)
 	{
 		Expression expr(expression);
 		vector<string> vars = expr.GetOperands();
 		map<string, double> values;
 
-		auto get_double_value = [&](const string& name, const variant<int, double, string>& var) -> double //   double  variant <...,double,....>
+		auto get_double_value = [&](const string& name, const variant<int, double, string>& var) -> double //эта штука достает double из variant <...,double,....>
 		{
 			return visit([&](auto&& arg) -> double
 			{	
 				using T = decay_t<decltype(arg)>;
 				if constexpr (is_same_v<T, int>)
 				{
-					return static_cast<double>(arg); //    double    variant<int, double>
+					return static_cast<double>(arg); // вероятно приведение к double хуже чем хранение variant<int, double>
 				}
 				else if constexpr (is_same_v<T, double>)
 				{
@@ -41,16 +44,87 @@ public:
 
 		for (const auto& var : vars) 
 		{
-			if (variables.find(var) != variables.end())
-				values[var] = get_double_value(var, variables[var]);
-			else if (constants.find(var) != constants.end())
-				values[var] = get_double_value(var, constants[var]);
+			auto variable = variables.find(var);
+			auto constant = constants.find(var);
+			if (variable != variables.end())
+				values[var] = get_double_value(var, variable->second);
+			else if (constant != constants.end())
+				values[var] = get_double_value(var, constant->second);
 			else
 				throw runtime_error("Undeclared identifier: " + var);
 		}
 		return expr.Calculate(values);
 	}
 
+	// Выражения проверены Resolver и переведены в байткод (CompiledExpression):
+	// имена связаны с ячейками контекста, у каждого известен тип. Поэтому число
+	// и строка считаются разными функциями без проверок во время работы; целые
+	// выражения - в int64 (IntegerArithmetic.h). stack вызывающего - не меньше
+	// expression.depth значений
+	static double evaluateNumber(const CompiledExpression& expression, const EvaluationContext& context, double* stack)
+	{
+		if (expression.type == ValueType::INTEGER)
+			return static_cast<double>(Bytecode::runInteger(expression.code.begin(), context, stack));
+		return Bytecode::run(expression.code.begin(), context, stack);
+	}
+
+	// только для целого выражения (type INTEGER)
+	static int64_t evaluateInteger(const CompiledExpression& expression, const EvaluationContext& context, double* stack)
+	{
+		return Bytecode::runInteger(expression.code.begin(), context, stack);
+	}
+
+	static void appendString(const CompiledExpression& expression, const EvaluationContext& context, string& result)
+	{
+		for (const StringPart& part : expression.parts)
+		{
+			if (part.slot == NO_SLOT)
+				result += part.text;
+			else
+				result += context.text(part.slot);
+		}
+	}
+
+	template <typename Number>
+	static bool compareNumbers(TokenTypes op, Number leftOp, Number rightOp)
+	{
+		switch (op)
+		{
+		case TokenTypes::EQUAL: return leftOp == rightOp;
+		case TokenTypes::NON_EQUAL: return leftOp != rightOp;
+		case TokenTypes::GREATER: return leftOp > rightOp;
+		case TokenTypes::GREATER_OR_EQUAL: return leftOp >= rightOp;
+		case TokenTypes::LESS: return leftOp < rightOp;
+		default: return leftOp <= rightOp;
+		}
+	}
+
+	// сравнение из условия if по скомпилированным частям; типы проверены Resolver
+	static bool compare(TokenTypes op, const CompiledExpression& left, const CompiledExpression& right, const EvaluationContext& context, double* stack)
+	{
+		if (left.type == ValueType::STRING)
+		{
+			string leftText, rightText;
+			appendString(left, context, leftText);
+			appendString(right, context, rightText);
+			return op == TokenTypes::EQUAL ? leftText == rightText : leftText != rightText;
+		}
+		try
+		{
+			if (left.type == ValueType::INTEGER && right.type == ValueType::INTEGER)
+			{
+				int64_t leftOp = evaluateInteger(left, context, stack);
+				return compareNumbers(op, leftOp, evaluateInteger(right, context, stack));
+			}
+			double leftOp = evaluateNumber(left, context, stack);
+			return compareNumbers(op, leftOp, evaluateNumber(right, context, stack));
+		}
+		catch (const exception& exc)
+		{
+			throw runtime_error("Invalid condition expression: " + string(exc.what()));
+		}
+	}
+
 	static string evaluate_string(const vector<Token>& expression, const unordered_map<string, variant<int, double, string>>& variables, const unordered_map<string, variant<int, double, string>>& constants)
 	{
 		bool last_sign = false;
@@ -67,7 +141,7 @@ public:
 			
 			TokenTypes::STRING_LITERAL:
 			{
-				if (!last_sign && !first_token) //   
+				if (!last_sign && !first_token) // два операнда подряд
 					throw runtime_error("Invalid string expression");
 				result += token.value;
 				first_token = false;
@@ -77,7 +151,7 @@ public:
 			case TokenTypes::IDENTIFIER:
 			{
 				try {
-					if (!last_sign && !first_token) //   
+					if (!last_sign && !first_token) // два операнда подряд
 						throw runtime_error("Invalid string expression");
 					if (variables.find(token.value) != variables.end())
 					{
@@ -6,6 +6,7 @@
 #include "ExpressionValidator.h"
 #include "PostfixConverter.h"
 #include "PostfixCalculator.h"
+#include "InfixCompiler.h"
 
 using namespace std;
 
@@ -13,33 +14,33 @@ class Expression
 {
 private:
     vector<Token> infix;
-    vector<Token> postfix;
     vector<string> operands;
+    CompiledPostfix compiled;      // собран в конструкторе за один проход
+    vector<double> operandValues;  // значения compiled.operands
 
 public: 
-    Expression(vector<Token>& expr) : infix(expr) {
-        ExpressionValidator::Validate(expr);
-        postfix = PostfixConverter::Convert(infix);
-        
-        for (Token tk : infix)
-            if (tk.type == 
-                
-                
-                
-                
-                
-                
-                
-                TokenTypes::IDENTIFIER)
+    // ошибки лексем и скобок - здесь, ошибки арности - из Calculate
+    Expression(const vector<Token>& expr) : infix(expr), compiled(InfixCompiler::Compile(expr)) {
+        operandValues.resize(compiled.operands.size());
+        for (const Token& tk : infix)
+            if (tk.type == TokenTypes::IDENTIFIER)
                 operands.push_back(tk.value);
     }
 
     vector<Token> GetInfix() const { return infix; };
-    vector<Token> GetPostfix() const { return postfix; };
+    // постфиксные лексемы для отладки; для вычисления они не нужны
+    vector<Token> GetPostfix() const { return PostfixConverter::Convert(infix); };
     vector<string> GetOperands() const { return operands; };
 
     double Calculate(const map<string, double>& values) {
-        return PostfixCalculator::Calculate(postfix, values);
+        if (!compiled.error.empty())
+            throw runtime_error(compiled.error);
+        for (size_t i = 0; i < compiled.operands.size(); i++) {
+            auto found = values.find(compiled.operands[i]);
+            if (found == values.end())
+                throw runtime_error("Operand value not found for identifier: " + compiled.operands[i]);
+            operandValues[i] = found->second;
+        }
+        return PostfixCalculator::Run(compiled, operandValues.data());
     }
 };
-
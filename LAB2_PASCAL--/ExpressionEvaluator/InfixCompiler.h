@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include "../Base/Token.h"
+#include "Bytecode.h"
+#include "PostfixCalculator.h"
+
+using namespace std;
+
+// Приоритеты бинарных операций по типу лексемы; 0 - не операция.
+// У '(' тоже 0: она не выталкивается операциями из стека.
+constexpr array<uint8_t, size_t(TokenTypes::UNKNOWN) + 1> makePrecedenceTable() {
+    array<uint8_t, size_t(TokenTypes::UNKNOWN) + 1> table{};
+    table[size_t(TokenTypes::PLUS)] = 1;
+    table[size_t(TokenTypes::MINUS)] = 1;
+    table[size_t(TokenTypes::MULTIPLY)] = 2;
+    table[size_t(TokenTypes::DIVIDE)] = 2;
+    table[size_t(TokenTypes::KEYWORD_DIV)] = 2;
+    table[size_t(TokenTypes::KEYWORD_MOD)] = 2;
+    return table;
+}
+
+inline constexpr array<uint8_t, size_t(TokenTypes::UNKNOWN) + 1> operatorPrecedence = makePrecedenceTable();
+
+// Инфиксное выражение сразу в байткод за один проход: проверка лексем и
+// скобок (как ExpressionValidator), различение унарного минуса и
+// сортировочная станция (как PostfixConverter) выполняются вместе, постфиксные
+// лексемы не создаются. Память берётся один раз под весь проход (код,
+// стек операций) и по разу на каждое новое имя операнда.
+class InfixCompiler {
+private:
+    static constexpr uint8_t unaryMinus = uint8_t(TokenTypes::UNKNOWN) + 1;  // в стеке операций
+    static constexpr uint8_t unaryPrecedence = 3;
+
+    static uint8_t precedenceOf(uint8_t pending) {
+        return pending == unaryMinus ? unaryPrecedence : operatorPrecedence[pending];
+    }
+
+    CompiledPostfix compiled;
+    BytecodeWriter writer;
+    // стек операций и '('; лексема операции нужна для сообщения об ошибке
+    struct Pending {
+        uint8_t operation;
+        string_view text;
+    };
+    vector<Pending> pending;
+    unordered_map<string_view, uint32_t> slots;
+
+    // операция уходит в код; первая ошибка арности запоминается, дальше
+    // код не пишется, но проверка лексем и скобок продолжается
+    void emit(const Pending& operation) {
+        if (!compiled.error.empty()) {
+            return;
+        }
+        if (operation.operation == unaryMinus) {
+            if (writer.stackDepth() < 1) {
+                compiled.error = "Invalid postfix expression: insufficient operands for unary minus";
+                return;
+            }
+            writer.negate();
+            return;
+        }
+        if (writer.stackDepth() < 2) {
+            compiled.error = "Invalid postfix expression: insufficient operands for operator " + string(operation.text);
+            return;
+        }
+        writer.binary(BytecodeWriter::opcodeOf(TokenTypes(operation.operation)));
+    }
+
+    void operand(const Token& token) {
+        if (!compiled.error.empty()) {
+            return;
+        }
+        if (token.type == TokenTypes::IDENTIFIER) {
+            auto found = slots.try_emplace(token.value, uint32_t(compiled.operands.size()));
+            if (found.second) {
+                compiled.operands.push_back(token.value);
+            }
+            writer.load(ValueType::DOUBLE, found.first->second);
+            return;
+        }
+        if (isnan(token.number)) {
+            compiled.error = "Invalid numeric literal: " + token.value;
+            return;
+        }
+        writer.constant(token.number);
+    }
+
+    void compile(const vector<Token>& infix) {
+        pending.reserve(infix.size());
+        writer.reserve(infix.size() * (1 + sizeof(double)) + 1);
+        bool expectOperand = true;
+        for (const Token& token : infix) {
+            switch (token.type) {
+            case TokenTypes::INTEGER_LITERAL:
+            case TokenTypes::DOUBLE_LITERAL:
+            case TokenTypes::IDENTIFIER:
+                operand(token);
+                expectOperand = false;
+                break;
+            case TokenTypes::LEFT_PAREN:
+                pending.push_back({ uint8_t(TokenTypes::LEFT_PAREN), token.value });
+                expectOperand = true;
+                break;
+            case TokenTypes::RIGHT_PAREN:
+                while (!pending.empty() && pending.back().operation != uint8_t(TokenTypes::LEFT_PAREN)) {
+                    emit(pending.back());
+                    pending.pop_back();
+                }
+                if (pending.empty()) {
+                    throw runtime_error("Closing parenthesis is not matched");
+                }
+                pending.pop_back();
+                expectOperand = false;
+                break;
+            default: {
+                uint8_t precedence = operatorPrecedence[size_t(token.type)];
+                if (precedence == 0) {
+                    throw runtime_error("Invalid character in expression");
+                }
+                if (token.type == TokenTypes::MINUS && expectOperand) {
+                    pending.push_back({ unaryMinus, token.value });
+                }
+                else {
+                    while (!pending.empty() && precedenceOf(pending.back().operation) >= precedence) {
+                        emit(pending.back());
+                        pending.pop_back();
+                    }
+                    pending.push_back({ uint8_t(token.type), token.value });
+                }
+                expectOperand = true;
+                break;
+            }
+            }
+        }
+        while (!pending.empty()) {
+            if (pending.back().operation == uint8_t(TokenTypes::LEFT_PAREN)) {
+                throw runtime_error("One or more opening parentheses are not paired");
+            }
+            emit(pending.back());
+            pending.pop_back();
+        }
+        if (compiled.error.empty() && writer.stackDepth() != 1) {
+            compiled.error = "Invalid postfix expression: too many operands or too few operators";
+        }
+        compiled.depth = writer.maxStackDepth();
+        compiled.code = writer.finish();
+    }
+
+public:
+    // Ошибки лексем и скобок бросаются сразу (как из ExpressionValidator),
+    // ошибка арности остаётся в error и выдаётся при вычислении (как из
+    // PostfixCalculator); код с ошибкой исполнять нельзя.
+    static CompiledPostfix Compile(const vector<Token>& infix) {
+        InfixCompiler compiler;
+        compiler.compile(infix);
+        return move(compiler.compiled);
+    }
+};
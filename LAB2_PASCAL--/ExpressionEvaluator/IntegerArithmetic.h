@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include "../Base/Token.h"
+
+using namespace std;
+
+// Целочисленные выражения (тип INTEGER после Resolver) считаются в int64 без
+// перехода в double: точно на всём диапазоне и с ошибкой при переполнении.
+// div округляет вниз, как floor(a / b) в вещественной арифметике, mod имеет
+// знак делимого, как fmod.
+class IntegerArithmetic {
+public:
+    [[noreturn]] static void overflow() {
+        throw runtime_error("Integer overflow");
+    }
+
+    static int64_t add(int64_t left, int64_t right) {
+        int64_t result;
+#if defined(__GNUC__) || defined(__clang__)
+        if (__builtin_add_overflow(left, right, &result)) overflow();
+#else
+        if ((right > 0 && left > INT64_MAX - right) || (right < 0 && left < INT64_MIN - right)) overflow();
+        result = left + right;
+#endif
+        return result;
+    }
+
+    static int64_t subtract(int64_t left, int64_t right) {
+        int64_t result;
+#if defined(__GNUC__) || defined(__clang__)
+        if (__builtin_sub_overflow(left, right, &result)) overflow();
+#else
+        if ((right < 0 && left > INT64_MAX + right) || (right > 0 && left < INT64_MIN + right)) overflow();
+        result = left - right;
+#endif
+        return result;
+    }
+
+    static int64_t multiply(int64_t left, int64_t right) {
+        int64_t result;
+#if defined(__GNUC__) || defined(__clang__)
+        if (__builtin_mul_overflow(left, right, &result)) overflow();
+#else
+        if (left > 0 ? (right > 0 ? left > INT64_MAX / right : right < INT64_MIN / left)
+                     : (right > 0 ? left < INT64_MIN / right : left != 0 && right < INT64_MAX / left))
+            overflow();
+        result = left * right;
+#endif
+        return result;
+    }
+
+    static int64_t negate(int64_t value) {
+        if (value == INT64_MIN) overflow();
+        return -value;
+    }
+
+    static int64_t div(int64_t left, int64_t right) {
+        if (right == 0) throw runtime_error("Integer division by zero");
+        if (right == -1) return negate(left);
+        int64_t quotient = left / right;
+        if (left % right != 0 && (left < 0) != (right < 0))
+            quotient--;
+        return quotient;
+    }
+
+    static int64_t mod(int64_t left, int64_t right) {
+        if (right == 0) throw runtime_error("Modulo by zero");
+        return right == -1 ? 0 : left % right;
+    }
+
+    // + - * div mod по типу лексемы
+    static int64_t apply(TokenTypes op, int64_t left, int64_t right) {
+        switch (op) {
+        case TokenTypes::PLUS: return add(left, right);
+        case TokenTypes::MINUS: return subtract(left, right);
+        case TokenTypes::MULTIPLY: return multiply(left, right);
+        case TokenTypes::KEYWORD_DIV: return div(left, right);
+        default: return mod(left, right);
+        }
+    }
+
+    // значение для целой переменной (int); не помещается - переполнение
+    static int narrow(int64_t value) {
+        if (value < numeric_limits<int>::min() || value > numeric_limits<int>::max()) overflow();
+        return static_cast<int>(value);
+    }
+
+    // вещественное для целой переменной: дробная часть отбрасывается,
+    // вне диапазона int (и NaN) - переполнение
+    static int truncate(double value) {
+        if (!(value > numeric_limits<int>::min() - 1.0 && value < numeric_limits<int>::max() + 1.0)) overflow();
+        return static_cast<int>(value);
+    }
+
+    // ячейка стека байткода - 8 байт: double или int64, какое именно - знает код
+    static int64_t load(const double* cell) {
+        int64_t value;
+        memcpy(&value, cell, sizeof(value));
+        return value;
+    }
+
+    static void store(double* cell, int64_t value) {
+        memcpy(cell, &value, sizeof(value));
+    }
+};
@@ -2,82 +2,121 @@
 
 #include "../Base/Token.h"
 #include "ExpressionValidator.h"
+#include "Bytecode.h"
 #include <vector>
 #include <string>
 #include <map>
 #include <stdexcept>
-#include <stack>
 #include <cmath>
 
 using namespace std;
 
+// Постфиксная запись, переведённая в байткод (Bytecode.h): имена
+// операндов заменены номерами в operands, числа лежат прямо в коде,
+// depth - наибольшая глубина стека. Один раз собранную запись можно
+// вычислять сколько угодно раз, не выделяя памяти.
+struct CompiledPostfix {
+    vector<uint8_t> code;
+    uint32_t depth = 0;
+    vector<string> operands;  // значения для Run - в этом порядке
+    string error;             // ошибка, найденная InfixCompiler; выдаётся при вычислении
+};
+
 class PostfixCalculator {
+private:
+    // значения операндов по номерам, все - double
+    struct OperandValues {
+        const double* values;
+        double integer(uint32_t slot) const { return values[slot]; }
+        double real(uint32_t slot) const { return values[slot]; }
+    };
+
+    static constexpr uint32_t smallStack = 32;
+
+    static uint32_t operandSlot(vector<string>& operands, const string& name) {
+        for (uint32_t slot = 0; slot < operands.size(); slot++) {
+            if (operands[slot] == name) {
+                return slot;
+            }
+        }
+        operands.push_back(name);
+        return uint32_t(operands.size() - 1);
+    }
+
 public:
-    static double Calculate(const vector<Token>& expr, const map<string, double>& operands) {
-        stack<double> st;
-        double leftOp, rightOp;
-        double operand;
+    static CompiledPostfix Compile(const vector<Token>& expr) {
+        CompiledPostfix compiled;
+        BytecodeWriter writer;
         for (const Token& tk : expr) {
-            string lexem = tk.value;
-            if (ExpressionValidator::IsOperator(lexem)) {
-                if (lexem == "_") {
-                    if (st.empty()) {
-                        throw runtime_error("Invalid postfix expression: insufficient operands for unary minus");
-                    }
-                    operand = st.top(); st.pop();
-                    st.push(-operand);
+            switch (tk.type) {
+            case TokenTypes::INTEGER_LITERAL:
+            case TokenTypes::DOUBLE_LITERAL:
+                // число разобрано при создании лексемы
+                if (isnan(tk.number)) {
+                    throw runtime_error("Invalid numeric literal: " + tk.value);
                 }
-                else {
-                    if (st.size() < 2)
-                        throw runtime_error("Invalid postfix expression: insufficient operands for operator " + lexem);
-
-                    rightOp = st.top(); st.pop();
-                    leftOp = st.top(); st.pop();
-
-                    if (lexem == "+")
-                        st.push(leftOp + rightOp);
-                    else if (lexem == "-")
-                        st.push(leftOp - rightOp);
-                    else if (lexem == "*")
-                        st.push(leftOp * rightOp);
-                    else if (lexem == "/") {
-                        if (rightOp == 0.0) throw runtime_error("Division by zero");
-                        st.push(leftOp / rightOp);
-                    }
-                    else if (lexem == "mod") {
-                        if (rightOp == 0.0) {
-                            throw runtime_error("Modulo by zero");
-                        }
-                        st.push(fmod(leftOp, rightOp));
-                    }
-                    else if (lexem == "div") {
-                        if (rightOp == 0.0) {
-                            throw runtime_error("Integer division by zero");
-                        }
-                        st.push(floor(leftOp / rightOp));
+                writer.constant(tk.number);
+                break;
+            case TokenTypes::IDENTIFIER:
+                writer.load(ValueType::DOUBLE, operandSlot(compiled.operands, tk.value));
+                break;
+            case TokenTypes::MINUS:
+                if (tk.value == "_") {
+                    if (writer.stackDepth() < 1) {
+                        throw runtime_error("Invalid postfix expression: insufficient operands for unary minus");
                     }
+                    writer.negate();
+                    break;
                 }
-            }
-            else if (tk.type == TokenTypes::IDENTIFIER) {
-                if (operands.count(lexem)) {
-                    st.push(operands.at(lexem));
-                }
-                else {
-                    throw runtime_error("Operand value not found for identifier: " + lexem);
+                [[fallthrough]];
+            case TokenTypes::PLUS:
+            case TokenTypes::MULTIPLY:
+            case TokenTypes::DIVIDE:
+            case TokenTypes::KEYWORD_DIV:
+            case TokenTypes::KEYWORD_MOD:
+                if (writer.stackDepth() < 2) {
+                    throw runtime_error("Invalid postfix expression: insufficient operands for operator " + tk.value);
                 }
-            }
-            else if (tk.type == TokenTypes::INTEGER_LITERAL) {
-                st.push(stod(lexem));
-            }
-            else if (tk.type == TokenTypes::DOUBLE_LITERAL) {
-                st.push(stod(lexem));
-            }
-            else
+                writer.binary(BytecodeWriter::opcodeOf(tk.type));
+                break;
+            default:
                 throw runtime_error("Unexpected token type in postfix expression: " + to_string(static_cast<int>(tk.type)));
+            }
         }
-        if (st.size() != 1) {
+        if (writer.stackDepth() != 1) {
             throw runtime_error("Invalid postfix expression: too many operands or too few operators");
         }
-        return st.top();
+        compiled.depth = writer.maxStackDepth();
+        compiled.code = writer.finish();
+        return compiled;
+    }
+
+    // values - значения compiled.operands по порядку, stack - не меньше compiled.depth
+    static double Run(const CompiledPostfix& compiled, const double* values, double* stack) {
+        return Bytecode::run(compiled.code.data(), OperandValues{ values }, stack);
+    }
+
+    // стек до smallStack значений берётся на месте, глубже - выделяется
+    static double Run(const CompiledPostfix& compiled, const double* values) {
+        if (compiled.depth <= smallStack) {
+            double stack[smallStack];
+            return Run(compiled, values, stack);
+        }
+        vector<double> stack(compiled.depth);
+        return Run(compiled, values, stack.data());
+    }
+
+    static double Calculate(const vector<Token>& expr, const map<string, double>& operands) {
+        CompiledPostfix compiled = Compile(expr);
+        vector<double> values;
+        values.reserve(compiled.operands.size());
+        for (const string& name : compiled.operands) {
+            auto found = operands.find(name);
+            if (found == operands.end()) {
+                throw runtime_error("Operand value not found for identifier: " + name);
+            }
+            values.push_back(found->second);
+        }
+        return Run(compiled, values.data());
     }
 };
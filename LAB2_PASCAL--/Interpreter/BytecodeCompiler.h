@@ -0,0 +1,346 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "../Base/Program.h"
+
+using namespace std;
+
+// Команды виртуальной машины (VirtualMachine.h). Код - поток байтов:
+// однобайтовая команда, затем её операнды прямо в коде - 8 байт double
+// (NUMBER) или int64 (INTEGER_NUMBER), 4 байта номера: ячейки в массиве её
+// типа, строковой константы, начала сообщения об ошибке, цели Read или
+// адреса перехода. Числа считаются на стеке 8-байтовых ячеек: целые
+// выражения - командами INTEGER_* в int64, вещественные - в double; строки
+// собираются в одном буфере-аккумуляторе.
+enum class VmOp : uint8_t {
+    NUMBER,            // d: положить число
+    LOAD_INTEGER,      // s: положить целую ячейку как double
+    LOAD_DOUBLE,       // s: положить вещественную ячейку
+    NEGATE,
+    ADD,
+    SUBTRACT,
+    MULTIPLY,
+    DIVIDE,            // c: начало сообщения при делении на 0
+    DIV,               // c
+    MOD,               // c
+    INTEGER_NUMBER,    // i: положить целое
+    INTEGER_LOAD,      // s: положить целую ячейку
+    INTEGER_NEGATE,    // c: начало сообщения при переполнении
+    INTEGER_ADD,       // c
+    INTEGER_SUBTRACT,  // c
+    INTEGER_MULTIPLY,  // c
+    INTEGER_DIV,       // c
+    INTEGER_MOD,       // c
+    TO_DOUBLE,         // целое на вершине - в double
+    STORE_INTEGER,     // s c: снять число, отбросить дробную часть; вне int - ошибка
+    STORE_DOUBLE,      // s: снять число
+    INTEGER_STORE,     // s c: снять целое, не помещается в int - ошибка
+    TEXT,              // k: дописать строковую константу в аккумулятор
+    TEXT_VARIABLE,     // s: дописать строковую ячейку в аккумулятор
+    STORE_TEXT,        // s: аккумулятор - в ячейку, аккумулятор пуст
+    SAVE_TEXT,         // аккумулятор - в левую часть сравнения строк
+    WRITE_NUMBER,      // снять число и дописать его запись в аккумулятор
+    WRITE_INTEGER,     // то же для целого
+    WRITE_LINE,        // вывести аккумулятор и перевод строки
+    READ,              // r: строка из cin в переменную reads[r]
+    JUMP,              // a: безусловный переход
+    JUMP_UNLESS_EQUAL, // a: снять два числа, перейти, если сравнение ложно
+    JUMP_UNLESS_NON_EQUAL,
+    JUMP_UNLESS_LESS,
+    JUMP_UNLESS_GREATER,
+    JUMP_UNLESS_LESS_OR_EQUAL,
+    JUMP_UNLESS_GREATER_OR_EQUAL,
+    JUMP_UNLESS_INTEGER_EQUAL,  // a: то же для двух целых
+    JUMP_UNLESS_INTEGER_NON_EQUAL,
+    JUMP_UNLESS_INTEGER_LESS,
+    JUMP_UNLESS_INTEGER_GREATER,
+    JUMP_UNLESS_INTEGER_LESS_OR_EQUAL,
+    JUMP_UNLESS_INTEGER_GREATER_OR_EQUAL,
+    JUMP_UNLESS_TEXT_EQUAL,     // a: сравнить левую часть с аккумулятором
+    JUMP_UNLESS_TEXT_NON_EQUAL, // a
+    HALT
+};
+
+constexpr size_t vmOpCount = size_t(VmOp::HALT) + 1;
+
+struct ProgramCode {
+    vector<uint8_t> code;
+    vector<string_view> texts;     // строковые константы, тексты - в арене Program
+    vector<string> contexts;       // начала сообщений об ошибках арифметики
+    vector<Name> reads;            // переменные операторов Read: тип, ячейка и имя
+    uint32_t depth = 0;            // наибольшая глубина стека чисел
+};
+
+// Перевод проверенной Resolver программы в код машины. Программа должна
+// жить дольше кода: строковые константы на неё ссылаются.
+class BytecodeCompiler {
+private:
+    ProgramCode result;
+    uint32_t depth = 0;  // чисел на стеке в текущей точке кода
+
+    template <typename T>
+    void operand(T value) {
+        size_t at = result.code.size();
+        result.code.resize(at + sizeof(T));
+        memcpy(result.code.data() + at, &value, sizeof(T));
+    }
+
+    void op(VmOp code) {
+        result.code.push_back(uint8_t(code));
+    }
+
+    void op(VmOp code, uint32_t argument) {
+        op(code);
+        operand(argument);
+    }
+
+    void pushed() {
+        if (++depth > result.depth) {
+            result.depth = depth;
+        }
+    }
+
+    // место под адрес перехода, его заполняет patch
+    size_t jump(VmOp code) {
+        op(code, 0);
+        return result.code.size() - sizeof(uint32_t);
+    }
+
+    void patch(size_t at) {
+        uint32_t target = uint32_t(result.code.size());
+        memcpy(result.code.data() + at, &target, sizeof(target));
+    }
+
+    uint32_t context(const string& text) {
+        for (uint32_t index = 0; index < result.contexts.size(); index++) {
+            if (result.contexts[index] == text) {
+                return index;
+            }
+        }
+        result.contexts.push_back(text);
+        return uint32_t(result.contexts.size() - 1);
+    }
+
+    // целое выражение целиком в int64
+    void integer(const Expr* expression, uint32_t errorContext) {
+        switch (expression->kind) {
+        case ExpressionKind::LITERAL:
+            op(VmOp::INTEGER_NUMBER);
+            operand(static_cast<const LiteralExpr*>(expression)->value.integer());
+            pushed();
+            break;
+        case ExpressionKind::IDENTIFIER:
+            op(VmOp::INTEGER_LOAD, static_cast<const IdentifierExpr*>(expression)->name.slot);
+            pushed();
+            break;
+        case ExpressionKind::NEGATE:
+            integer(static_cast<const UnaryExpr*>(expression)->operand, errorContext);
+            op(VmOp::INTEGER_NEGATE, errorContext);
+            break;
+        default: {
+            const auto binary = static_cast<const BinaryExpr*>(expression);
+            integer(binary->left, errorContext);
+            integer(binary->right, errorContext);
+            switch (binary->op) {
+            case TokenTypes::PLUS: op(VmOp::INTEGER_ADD, errorContext); break;
+            case TokenTypes::MINUS: op(VmOp::INTEGER_SUBTRACT, errorContext); break;
+            case TokenTypes::MULTIPLY: op(VmOp::INTEGER_MULTIPLY, errorContext); break;
+            case TokenTypes::KEYWORD_DIV: op(VmOp::INTEGER_DIV, errorContext); break;
+            default: op(VmOp::INTEGER_MOD, errorContext); break;
+            }
+            depth--;
+            break;
+        }
+        }
+    }
+
+    // вещественное выражение: целые подвыражения считаются в int64 и
+    // переводятся в double, целые литералы и ячейки читаются сразу как double
+    void number(const Expr* expression, uint32_t errorContext) {
+        if (expression->type == ValueType::INTEGER && expression->kind != ExpressionKind::LITERAL && expression->kind != ExpressionKind::IDENTIFIER) {
+            integer(expression, errorContext);
+            op(VmOp::TO_DOUBLE);
+            return;
+        }
+        switch (expression->kind) {
+        case ExpressionKind::LITERAL:
+            op(VmOp::NUMBER);
+            operand(static_cast<const LiteralExpr*>(expression)->value.number());
+            pushed();
+            break;
+        case ExpressionKind::IDENTIFIER:
+            op(expression->type == ValueType::INTEGER ? VmOp::LOAD_INTEGER : VmOp::LOAD_DOUBLE,
+                static_cast<const IdentifierExpr*>(expression)->name.slot);
+            pushed();
+            break;
+        case ExpressionKind::NEGATE:
+            number(static_cast<const UnaryExpr*>(expression)->operand, errorContext);
+            op(VmOp::NEGATE);
+            break;
+        default: {
+            const auto binary = static_cast<const BinaryExpr*>(expression);
+            number(binary->left, errorContext);
+            number(binary->right, errorContext);
+            switch (binary->op) {
+            case TokenTypes::PLUS: op(VmOp::ADD); break;
+            case TokenTypes::MINUS: op(VmOp::SUBTRACT); break;
+            case TokenTypes::MULTIPLY: op(VmOp::MULTIPLY); break;
+            case TokenTypes::DIVIDE: op(VmOp::DIVIDE, errorContext); break;
+            case TokenTypes::KEYWORD_DIV: op(VmOp::DIV, errorContext); break;
+            default: op(VmOp::MOD, errorContext); break;
+            }
+            depth--;
+            break;
+        }
+        }
+    }
+
+    // части строкового выражения дописываются в аккумулятор
+    void text(const Expr* expression) {
+        switch (expression->kind) {
+        case ExpressionKind::LITERAL:
+            op(VmOp::TEXT, uint32_t(result.texts.size()));
+            result.texts.push_back(static_cast<const LiteralExpr*>(expression)->value.text());
+            break;
+        case ExpressionKind::IDENTIFIER:
+            op(VmOp::TEXT_VARIABLE, static_cast<const IdentifierExpr*>(expression)->name.slot);
+            break;
+        default: {
+            const auto binary = static_cast<const BinaryExpr*>(expression);
+            text(binary->left);
+            text(binary->right);
+            break;
+        }
+        }
+    }
+
+    static VmOp jumpUnless(TokenTypes comparison, ValueType operands) {
+        if (operands == ValueType::STRING) {
+            return comparison == TokenTypes::EQUAL ? VmOp::JUMP_UNLESS_TEXT_EQUAL : VmOp::JUMP_UNLESS_TEXT_NON_EQUAL;
+        }
+        if (operands == ValueType::INTEGER) {
+            // целые команды идут в том же порядке, что и вещественные
+            return VmOp(uint8_t(jumpUnless(comparison, ValueType::DOUBLE)) - uint8_t(VmOp::JUMP_UNLESS_EQUAL) + uint8_t(VmOp::JUMP_UNLESS_INTEGER_EQUAL));
+        }
+        switch (comparison) {
+        case TokenTypes::EQUAL: return VmOp::JUMP_UNLESS_EQUAL;
+        case TokenTypes::NON_EQUAL: return VmOp::JUMP_UNLESS_NON_EQUAL;
+        case TokenTypes::LESS: return VmOp::JUMP_UNLESS_LESS;
+        case TokenTypes::GREATER: return VmOp::JUMP_UNLESS_GREATER;
+        case TokenTypes::LESS_OR_EQUAL: return VmOp::JUMP_UNLESS_LESS_OR_EQUAL;
+        default: return VmOp::JUMP_UNLESS_GREATER_OR_EQUAL;
+        }
+    }
+
+    void block(Span<Statement*> statements) {
+        for (const Statement* statement : statements) {
+            compileStatement(statement);
+        }
+    }
+
+    void compileStatement(const Statement* node) {
+        switch (node->type) {
+        case Node::NodeType::ASSIGNMENT_STATEMENT: {
+            const auto assign = static_cast<const AssignStatement*>(node);
+            if (assign->value->type == ValueType::STRING) {
+                text(assign->value);
+                op(VmOp::STORE_TEXT, assign->target.slot);
+                break;
+            }
+            uint32_t errorContext = context("Failed to assign " + string(assign->target.text) + ": ");
+            if (assign->target.type == ValueType::INTEGER && assign->value->type == ValueType::INTEGER) {
+                integer(assign->value, errorContext);
+                op(VmOp::INTEGER_STORE, assign->target.slot);
+                operand(errorContext);
+            }
+            else {
+                number(assign->value, errorContext);
+                if (assign->target.type == ValueType::INTEGER) {
+                    op(VmOp::STORE_INTEGER, assign->target.slot);
+                    operand(errorContext);
+                }
+                else {
+                    op(VmOp::STORE_DOUBLE, assign->target.slot);
+                }
+            }
+            depth--;
+            break;
+        }
+        case Node::NodeType::WRITE_STATEMENT: {
+            uint32_t errorContext = context("Runtime Error in Write statement: Could not evaluate the expression: ");
+            for (const Expr* argument : static_cast<const WriteStatement*>(node)->arguments) {
+                if (argument->type == ValueType::STRING) {
+                    text(argument);
+                    continue;
+                }
+                if (argument->type == ValueType::INTEGER) {
+                    integer(argument, errorContext);
+                    op(VmOp::WRITE_INTEGER);
+                }
+                else {
+                    number(argument, errorContext);
+                    op(VmOp::WRITE_NUMBER);
+                }
+                depth--;
+            }
+            op(VmOp::WRITE_LINE);
+            break;
+        }
+        case Node::NodeType::READ_STATEMENT:
+            for (const Name& target : static_cast<const ReadStatement*>(node)->targets) {
+                op(VmOp::READ, uint32_t(result.reads.size()));
+                result.reads.push_back(target);
+            }
+            break;
+        case Node::NodeType::IF_STATEMENT: {
+            const auto ifStatement = static_cast<const IfStatement*>(node);
+            const auto condition = static_cast<const BinaryExpr*>(ifStatement->condition);
+            ValueType operands = condition->type;
+            if (operands == ValueType::STRING) {
+                text(condition->left);
+                op(VmOp::SAVE_TEXT);
+                text(condition->right);
+            }
+            else {
+                uint32_t errorContext = context("Invalid condition expression: ");
+                if (condition->left->type == ValueType::INTEGER && condition->right->type == ValueType::INTEGER) {
+                    operands = ValueType::INTEGER;
+                    integer(condition->left, errorContext);
+                    integer(condition->right, errorContext);
+                }
+                else {
+                    operands = ValueType::DOUBLE;
+                    number(condition->left, errorContext);
+                    number(condition->right, errorContext);
+                }
+                depth -= 2;
+            }
+            size_t toElse = jump(jumpUnless(condition->op, operands));
+            block(ifStatement->thenBranch);
+            if (ifStatement->elseBranch.empty()) {
+                patch(toElse);
+                break;
+            }
+            size_t toEnd = jump(VmOp::JUMP);
+            patch(toElse);
+            block(ifStatement->elseBranch);
+            patch(toEnd);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+public:
+    static ProgramCode compile(const Program& program) {
+        BytecodeCompiler compiler;
+        compiler.block(program.body);
+        compiler.op(VmOp::HALT);
+        return move(compiler.result);
+    }
+};
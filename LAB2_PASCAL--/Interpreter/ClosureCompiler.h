@@ -0,0 +1,294 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cmath>
+#include <stdexcept>
+#include "../Base/Program.h"
+#include "Console.h"
+#include "../ExpressionEvaluator/IntegerArithmetic.h"
+
+using namespace std;
+
+// Перевод проверенной Resolver программы в дерево замыканий: каждый узел
+// (оператор, выражение, условие) один раз превращается в функцию, которая
+// уже знает свои ячейки, операции и дочерние функции. Исполнение - только
+// вызовы замыканий, без разбора вида узла и без лексем.
+// По замерам (interpreter --bench) это не быстрее обхода дерева: вызов
+// function на каждый узел стоит не меньше, чем switch по виду узла.
+// Быстрее обоих - виртуальная машина (VirtualMachine.h).
+
+// то, что замыкания получают при исполнении
+struct ClosureState {
+    VariableStorage& storage;
+    string scratch;  // сборка строкового присваивания
+};
+
+using NumberClosure = function<double(const ClosureState&)>;
+using IntegerClosure = function<int64_t(const ClosureState&)>;  // целое выражение в int64
+using TextClosure = function<void(const ClosureState&, string&)>;  // дописывает значение
+using ConditionClosure = function<bool(ClosureState&)>;
+using StatementClosure = function<void(ClosureState&)>;
+
+class ClosureCompiler {
+private:
+    // левая часть вычисляется первой - ошибка из неё выдаётся раньше
+    template <typename Closure, typename Operation>
+    static Closure binary(Closure left, Closure right, Operation operation) {
+        return [left = move(left), right = move(right), operation](const ClosureState& state) {
+            auto leftValue = left(state);
+            return operation(leftValue, right(state));
+        };
+    }
+
+    static IntegerClosure integer(const Expr* expression) {
+        switch (expression->kind) {
+        case ExpressionKind::LITERAL: {
+            int64_t value = static_cast<const LiteralExpr*>(expression)->value.integer();
+            return [value](const ClosureState&) { return value; };
+        }
+        case ExpressionKind::IDENTIFIER: {
+            uint32_t slot = static_cast<const IdentifierExpr*>(expression)->name.slot;
+            return [slot](const ClosureState& state) { return int64_t(state.storage.integers[slot]); };
+        }
+        case ExpressionKind::NEGATE:
+            return [operand = integer(static_cast<const UnaryExpr*>(expression)->operand)](const ClosureState& state) {
+                return IntegerArithmetic::negate(operand(state));
+            };
+        default:
+            break;
+        }
+        const auto node = static_cast<const BinaryExpr*>(expression);
+        IntegerClosure left = integer(node->left), right = integer(node->right);
+        switch (node->op) {
+        case TokenTypes::PLUS: return binary(move(left), move(right), IntegerArithmetic::add);
+        case TokenTypes::MINUS: return binary(move(left), move(right), IntegerArithmetic::subtract);
+        case TokenTypes::MULTIPLY: return binary(move(left), move(right), IntegerArithmetic::multiply);
+        case TokenTypes::KEYWORD_DIV: return binary(move(left), move(right), IntegerArithmetic::div);
+        default: return binary(move(left), move(right), IntegerArithmetic::mod);
+        }
+    }
+
+    // целые подвыражения считаются в int64 и переводятся в double только здесь
+    static NumberClosure number(const Expr* expression) {
+        if (expression->type == ValueType::INTEGER && expression->kind != ExpressionKind::LITERAL && expression->kind != ExpressionKind::IDENTIFIER) {
+            return [value = integer(expression)](const ClosureState& state) { return double(value(state)); };
+        }
+        switch (expression->kind) {
+        case ExpressionKind::LITERAL: {
+            double value = static_cast<const LiteralExpr*>(expression)->value.number();
+            return [value](const ClosureState&) { return value; };
+        }
+        case ExpressionKind::IDENTIFIER: {
+            uint32_t slot = static_cast<const IdentifierExpr*>(expression)->name.slot;
+            if (expression->type == ValueType::INTEGER)
+                return [slot](const ClosureState& state) { return double(state.storage.integers[slot]); };
+            return [slot](const ClosureState& state) { return state.storage.reals[slot]; };
+        }
+        case ExpressionKind::NEGATE:
+            return [operand = number(static_cast<const UnaryExpr*>(expression)->operand)](const ClosureState& state) {
+                return -operand(state);
+            };
+        default:
+            break;
+        }
+        const auto node = static_cast<const BinaryExpr*>(expression);
+        NumberClosure left = number(node->left), right = number(node->right);
+        switch (node->op) {
+        case TokenTypes::PLUS:
+            return binary(move(left), move(right), [](double a, double b) { return a + b; });
+        case TokenTypes::MINUS:
+            return binary(move(left), move(right), [](double a, double b) { return a - b; });
+        case TokenTypes::MULTIPLY:
+            return binary(move(left), move(right), [](double a, double b) { return a * b; });
+        case TokenTypes::DIVIDE:
+            return binary(move(left), move(right), [](double a, double b) {
+                if (b == 0.0) throw runtime_error("Division by zero");
+                return a / b;
+            });
+        case TokenTypes::KEYWORD_DIV:
+            return binary(move(left), move(right), [](double a, double b) {
+                if (b == 0.0) throw runtime_error("Integer division by zero");
+                return floor(a / b);
+            });
+        default:
+            return binary(move(left), move(right), [](double a, double b) {
+                if (b == 0.0) throw runtime_error("Modulo by zero");
+                return fmod(a, b);
+            });
+        }
+    }
+
+    static TextClosure text(const Expr* expression) {
+        switch (expression->kind) {
+        case ExpressionKind::LITERAL: {
+            string_view value = static_cast<const LiteralExpr*>(expression)->value.text();
+            return [value](const ClosureState&, string& result) { result += value; };
+        }
+        case ExpressionKind::IDENTIFIER: {
+            uint32_t slot = static_cast<const IdentifierExpr*>(expression)->name.slot;
+            return [slot](const ClosureState& state, string& result) { result += state.storage.texts[slot]; };
+        }
+        default: {
+            const auto node = static_cast<const BinaryExpr*>(expression);
+            return [left = text(node->left), right = text(node->right)](const ClosureState& state, string& result) {
+                left(state, result);
+                right(state, result);
+            };
+        }
+        }
+    }
+
+    // ошибка вычисления числа получает начало сообщения, как в обходе дерева
+    template <typename Closure>
+    static Closure withContext(Closure value, string context) {
+        return [value = move(value), context = move(context)](const ClosureState& state) {
+            try {
+                return value(state);
+            }
+            catch (const exception& exc) {
+                throw runtime_error(context + exc.what());
+            }
+        };
+    }
+
+    static ConditionClosure condition(const BinaryExpr* comparison) {
+        if (comparison->type == ValueType::STRING) {
+            bool equal = comparison->op == TokenTypes::EQUAL;
+            return [equal, left = text(comparison->left), right = text(comparison->right)](ClosureState& state) {
+                string leftText, rightText;
+                left(state, leftText);
+                right(state, rightText);
+                return (leftText == rightText) == equal;
+            };
+        }
+        const string context = "Invalid condition expression: ";
+        if (comparison->left->type == ValueType::INTEGER && comparison->right->type == ValueType::INTEGER)
+            return compare(comparison->op, withContext(integer(comparison->left), context), withContext(integer(comparison->right), context));
+        return compare(comparison->op, withContext(number(comparison->left), context), withContext(number(comparison->right), context));
+    }
+
+    template <typename Closure>
+    static ConditionClosure compare(TokenTypes op, Closure left, Closure right) {
+        auto make = [&left, &right](auto operation) -> ConditionClosure {
+            return [left = move(left), right = move(right), operation](ClosureState& state) {
+                auto leftValue = left(state);
+                return operation(leftValue, right(state));
+            };
+        };
+        switch (op) {
+        case TokenTypes::EQUAL: return make(equal_to<>());
+        case TokenTypes::NON_EQUAL: return make(not_equal_to<>());
+        case TokenTypes::GREATER: return make(greater<>());
+        case TokenTypes::GREATER_OR_EQUAL: return make(greater_equal<>());
+        case TokenTypes::LESS: return make(less<>());
+        default: return make(less_equal<>());
+        }
+    }
+
+    static StatementClosure assignment(const AssignStatement* assign) {
+        uint32_t slot = assign->target.slot;
+        if (assign->target.type == ValueType::STRING) {
+            return [slot, value = text(assign->value)](ClosureState& state) {
+                // выражение может читать ту же переменную: собираем рядом и меняем местами
+                state.scratch.clear();
+                value(state, state.scratch);
+                state.storage.texts[slot].swap(state.scratch);
+            };
+        }
+        string context = "Failed to assign " + string(assign->target.text) + ": ";
+        if (assign->target.type == ValueType::INTEGER && assign->value->type == ValueType::INTEGER) {
+            return [slot, value = integer(assign->value), context](ClosureState& state) {
+                try {
+                    state.storage.integers[slot] = IntegerArithmetic::narrow(value(state));
+                }
+                catch (const exception& exc) {
+                    throw runtime_error(context + exc.what());
+                }
+            };
+        }
+        if (assign->target.type == ValueType::INTEGER) {
+            return [slot, value = number(assign->value), context](ClosureState& state) {
+                try {
+                    state.storage.integers[slot] = IntegerArithmetic::truncate(value(state));
+                }
+                catch (const exception& exc) {
+                    throw runtime_error(context + exc.what());
+                }
+            };
+        }
+        NumberClosure value = withContext(number(assign->value), context);
+        return [slot, value = move(value)](ClosureState& state) { state.storage.reals[slot] = value(state); };
+    }
+
+    static StatementClosure write(const WriteStatement* writeStatement) {
+        vector<TextClosure> parts;
+        for (const Expr* argument : writeStatement->arguments) {
+            if (argument->type == ValueType::STRING) {
+                parts.push_back(text(argument));
+                continue;
+            }
+            const string context = "Runtime Error in Write statement: Could not evaluate the expression: ";
+            if (argument->type == ValueType::INTEGER) {
+                IntegerClosure value = withContext(integer(argument), context);
+                parts.push_back([value = move(value)](const ClosureState& state, string& result) { result += to_string(value(state)); });
+                continue;
+            }
+            NumberClosure value = withContext(number(argument), context);
+            parts.push_back([value = move(value)](const ClosureState& state, string& result) { result += num_to_str(value(state)); });
+        }
+        return [parts = move(parts)](ClosureState& state) {
+            string record;
+            for (const TextClosure& part : parts)
+                part(state, record);
+            cout << record << '\n';
+        };
+    }
+
+    static StatementClosure read(const ReadStatement* readStatement) {
+        vector<Name> targets(readStatement->targets.begin(), readStatement->targets.end());
+        return [targets = move(targets)](ClosureState& state) {
+            for (const Name& target : targets)
+                read_variable(state.storage, target);
+        };
+    }
+
+    static StatementClosure ifStatement(const IfStatement* node) {
+        return [test = condition(static_cast<const BinaryExpr*>(node->condition)),
+                thenBranch = block(node->thenBranch), elseBranch = block(node->elseBranch)](ClosureState& state) {
+            for (const StatementClosure& statement : test(state) ? thenBranch : elseBranch)
+                statement(state);
+        };
+    }
+
+    static vector<StatementClosure> block(Span<Statement*> statements) {
+        vector<StatementClosure> result;
+        for (const Statement* node : statements) {
+            switch (node->type) {
+            case Node::NodeType::ASSIGNMENT_STATEMENT:
+                result.push_back(assignment(static_cast<const AssignStatement*>(node)));
+                break;
+            case Node::NodeType::WRITE_STATEMENT:
+                result.push_back(write(static_cast<const WriteStatement*>(node)));
+                break;
+            case Node::NodeType::READ_STATEMENT:
+                result.push_back(read(static_cast<const ReadStatement*>(node)));
+                break;
+            case Node::NodeType::IF_STATEMENT:
+                result.push_back(ifStatement(static_cast<const IfStatement*>(node)));
+                break;
+            default:
+                break;  // объявления разобраны Resolver
+            }
+        }
+        return result;
+    }
+
+public:
+    // Программа должна жить дольше замыканий: строковые константы на неё ссылаются
+    static vector<StatementClosure> compile(const Program& program) {
+        return block(program.body);
+    }
+};
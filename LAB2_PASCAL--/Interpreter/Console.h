@@ -0,0 +1,59 @@
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <stdexcept>
+#include "../Base/VariableStorage.h"
+using namespace std;
+
+// Ввод и вывод программы, общие для всех способов исполнения
+
+const int pascal_precision = 14;
+
+const string num_to_str(const double num)
+{
+	stringstream ss;
+	ss << fixed << setprecision(pascal_precision) << num;
+	string str = ss.str();
+	size_t dot_pos = str.find('.');
+	for (size_t i = str.size() - 1; i > dot_pos - 1; i--)
+	{
+		if (str[i] != '0' && i != dot_pos)
+			break;
+		str.erase(i);
+	}
+	return str;
+}
+
+// строка из cin, разобранная по типу переменной
+template <typename T>
+void read_variable(T& variable, string_view name)
+{
+	string input;
+	getline(cin, input);
+	try
+	{
+		if constexpr (is_same_v<T, int>) variable = stoi(input);
+		else if constexpr (is_same_v<T, double>) variable = stod(input);
+		else variable = move(input);
+	}
+	catch (const invalid_argument& e) {
+		throw runtime_error("Invalid input for variable " + string(name) + ": " + e.what());
+	}
+	catch (const out_of_range& e) {
+		throw runtime_error("Input value out of range for variable " + string(name) + ": " + e.what());
+	}
+}
+
+inline void read_variable(VariableStorage& storage, const Name& target)
+{
+	switch (target.type) {
+		case ValueType::INTEGER: read_variable(storage.integers[target.slot], target.text); break;
+		case ValueType::DOUBLE: read_variable(storage.reals[target.slot], target.text); break;
+		default: read_variable(storage.texts[target.slot], target.text); break;
+	}
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include "../Base/Program.h"
+
+using namespace std;
+
+// Проход между разбором и исполнением: связывает каждое имя с константой
+// или с ячейкой переменной. Константы подставляются в выражения как
+// литералы, переменные получают номера ячеек 0, 1, 2 ... в порядке
+// объявления отдельно для каждого типа (integer, double, string). Заодно
+// выводится тип каждого выражения: числовое (integer, double) или
+// строковое. Ошибки объявлений, необъявленные имена и ошибки типов
+// выдаются здесь, до исполнения первого оператора; во время работы имена
+// уже не ищутся, а вычислитель выбирается по типу заранее.
+class Resolver {
+private:
+    struct Binding {
+        const ConstStatement* constant; // nullptr у переменной
+        uint32_t variable;              // номер в slots
+    };
+
+    Program& program;
+    unordered_map<string_view, Binding> bindings;
+    vector<VariableSlot> slots;
+    uint32_t slotCounts[3] = {};  // занято ячеек каждого типа
+
+    const Binding* find(string_view name) const {
+        auto found = bindings.find(name);
+        return found == bindings.end() ? nullptr : &found->second;
+    }
+
+    void declareConstant(ConstStatement* constStatement) {
+        const Binding* previous = find(constStatement->name.text);
+        if (previous && previous->constant)
+            throw runtime_error("Constant already declared: " + string(constStatement->name.text));
+        bindings[constStatement->name.text] = Binding{ constStatement, NO_SLOT };
+    }
+
+    void declareVariables(VarStatement* varStatement) {
+        for (Name& name : varStatement->names) {
+            const Binding* previous = find(name.text);
+            if (previous && previous->constant)
+                throw runtime_error("Redeclared constant name: " + string(name.text));
+            if (previous)
+                throw runtime_error("Variable already declared: " + string(name.text));
+            name.type = varStatement->declared;
+            name.slot = slotCounts[size_t(name.type)]++;
+            bindings[name.text] = Binding{ nullptr, uint32_t(slots.size()) };
+            slots.push_back(VariableSlot{ name.text, name.type, name.slot });
+        }
+    }
+
+    // имя, которому присваивают или в которое читают
+    void bindTarget(Name& name, const string& constantError, const string& undeclaredError) {
+        const Binding* binding = find(name.text);
+        if (binding && binding->constant)
+            throw runtime_error(constantError + string(name.text));
+        if (!binding)
+            throw runtime_error(undeclaredError + string(name.text));
+        bindVariable(name, *binding);
+    }
+
+    void bindVariable(Name& name, const Binding& binding) const {
+        name.slot = slots[binding.variable].slot;
+        name.type = slots[binding.variable].type;
+    }
+
+    // ссылка на узел, потому что константа заменяет собой узел имени
+    void resolveExpression(Expr*& expression, const string& context) {
+        switch (expression->kind) {
+        case ExpressionKind::LITERAL:
+            expression->type = static_cast<LiteralExpr*>(expression)->value.type();
+            break;
+        case ExpressionKind::IDENTIFIER: {
+            Name& name = static_cast<IdentifierExpr*>(expression)->name;
+            const Binding* binding = find(name.text);
+            if (!binding)
+                throw runtime_error(context + "Undeclared identifier: " + string(name.text));
+            if (binding->constant) {
+                // все подстановки константы делят одну строку в арене
+                const Value& value = binding->constant->value;
+                expression = program.arena.make<LiteralExpr>(Expr{ ExpressionKind::LITERAL, TokenTypes::UNKNOWN, value.type() }, value);
+            }
+            else {
+                bindVariable(name, *binding);
+                expression->type = name.type;
+            }
+            break;
+        }
+        case ExpressionKind::NEGATE: {
+            Expr*& operand = static_cast<UnaryExpr*>(expression)->operand;
+            resolveExpression(operand, context);
+            if (operand->type == ValueType::STRING)
+                throw runtime_error(context + "Unary minus applied to a string");
+            expression->type = operand->type;
+            break;
+        }
+        default: {
+            auto binary = static_cast<BinaryExpr*>(expression);
+            resolveExpression(binary->left, context);
+            resolveExpression(binary->right, context);
+            bool leftString = binary->left->type == ValueType::STRING;
+            bool rightString = binary->right->type == ValueType::STRING;
+            if (leftString || rightString) {
+                if (leftString != rightString || binary->op != TokenTypes::PLUS)
+                    throw runtime_error(context + "Invalid string expression: only strings can be joined with '+'");
+                expression->type = ValueType::STRING;
+            }
+            else if (binary->op == TokenTypes::DIVIDE || binary->left->type == ValueType::DOUBLE || binary->right->type == ValueType::DOUBLE) {
+                expression->type = ValueType::DOUBLE;
+            }
+            else {
+                expression->type = ValueType::INTEGER;
+            }
+            break;
+        }
+        }
+    }
+
+    static bool isString(const Expr* expression) {
+        return expression->type == ValueType::STRING;
+    }
+
+    void resolveBlock(Span<Statement*> block) {
+        for (Statement* statement : block)
+            resolveStatement(statement);
+    }
+
+    void resolveStatement(Statement* node) {
+        switch (node->type) {
+        case Node::NodeType::CONST_DECLARATION:
+            declareConstant(static_cast<ConstStatement*>(node));
+            break;
+        case Node::NodeType::VARIABLE_DECLARATION:
+            declareVariables(static_cast<VarStatement*>(node));
+            break;
+        case Node::NodeType::ASSIGNMENT_STATEMENT: {
+            auto assign = static_cast<AssignStatement*>(node);
+            bindTarget(assign->target, "Assignment to constant: ", "Undeclared variable assignment: ");
+            if (!assign->error.empty())
+                throw runtime_error(string(assign->error));
+            string context = "Failed to assign " + string(assign->target.text) + ": ";
+            resolveExpression(assign->value, context);
+            if (isString(assign->value) != (assign->target.type == ValueType::STRING))
+                throw runtime_error(context + "Type mismatch");
+            break;
+        }
+        case Node::NodeType::WRITE_STATEMENT: {
+            auto write = static_cast<WriteStatement*>(node);
+            if (!write->error.empty())
+                throw runtime_error(string(write->error));
+            for (Expr*& argument : write->arguments)
+                resolveExpression(argument, "Runtime Error in Write statement: Could not evaluate the expression: ");
+            break;
+        }
+        case Node::NodeType::READ_STATEMENT:
+            for (Name& target : static_cast<ReadStatement*>(node)->targets)
+                bindTarget(target, "Input to constant not allowed: ", "Undeclared variable: ");
+            break;
+        case Node::NodeType::IF_STATEMENT: {
+            auto ifStatement = static_cast<IfStatement*>(node);
+            if (!ifStatement->error.empty())
+                throw runtime_error(string(ifStatement->error));
+            auto comparison = static_cast<BinaryExpr*>(ifStatement->condition);
+            resolveExpression(comparison->left, "Invalid condition expression: ");
+            resolveExpression(comparison->right, "Invalid condition expression: ");
+            if (isString(comparison->left) != isString(comparison->right))
+                throw runtime_error("Type mismatch error in conditional expression");
+            if (isString(comparison->left) && comparison->op != TokenTypes::EQUAL && comparison->op != TokenTypes::NON_EQUAL)
+                throw runtime_error("Cannot compare strings using ordering operators");
+            comparison->type = comparison->left->type;
+            resolveBlock(ifStatement->thenBranch);
+            resolveBlock(ifStatement->elseBranch);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    explicit Resolver(Program& target) : program(target) {}
+
+public:
+    // при ошибке бросает runtime_error; программу после этого исполнять нельзя
+    static void resolve(Program& program) {
+        Resolver resolver(program);
+        resolver.resolveBlock(program.constSection);
+        resolver.resolveBlock(program.varSection);
+        resolver.resolveBlock(program.body);
+        program.variables = program.arena.copy(resolver.slots);
+    }
+};
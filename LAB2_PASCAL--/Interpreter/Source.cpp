@@ -2,14 +2,467 @@
 #include "../Lexer/Lexer.h"
 #include "../Parser/Parser.h"
 #include "../ExpressionEvaluator/PostfixConverter.cpp"
+#include "../Base/SourceBuffer.cpp"
 #include <iostream>
 #include <string>
 #include <vector>
 #include <variant>
+#include <chrono>
 
+// Запуск программы из файла: interpreter <file.pas>, "-" - чтение из стандартного ввода,
+// interpreter --bench - замеры производительности
+int runFile(const string& path)
+{
+	try {
+		Lexer lexer(path == "-" ? SourceBuffer::fromStream(cin) : SourceBuffer::fromFile(path));
+		Parser parser(lexer);
+		Interpreter inter(parser.parseProgram());
+		inter.run();
+	}
+	catch (const exception& e) {
+		cerr << "Error: " << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
+
+// выражение из одних литералов, вычисляемое миллион раз
+void benchmarkLiterals()
+{
+	const int rounds = 1000000;
+	Lexer lexer("1.5 * 2 + 3.25 * 4 - 5 / 2.5 + 6 * 7 - 8.75 + 9 div 2 + 10 mod 3 - 11.125 * 12");
+	vector<Token> expression = lexer.tokenize();
+	vector<Token> postfix = PostfixConverter::Convert(expression);
+	map<string, double> noOperands;
+	unordered_map<string, variant<int, double, string>> variables, constants;
+
+	double checksum = 0;
+	auto start = chrono::high_resolution_clock::now();
+	for (int i = 0; i < rounds; i++)
+		checksum += PostfixCalculator::Calculate(postfix, noOperands);
+	auto middle = chrono::high_resolution_clock::now();
+	for (int i = 0; i < rounds; i++)
+		checksum += Evaluator::evaluate_numeric(expression, variables, constants);
+	auto afterEvaluate = chrono::high_resolution_clock::now();
+	CompiledPostfix compiled = PostfixCalculator::Compile(postfix);
+	for (int i = 0; i < rounds; i++)
+		checksum += PostfixCalculator::Run(compiled, nullptr);
+	auto end = chrono::high_resolution_clock::now();
+
+	chrono::duration<double> calculateTime = middle - start;
+	chrono::duration<double> evaluateTime = afterEvaluate - middle;
+	chrono::duration<double> runTime = end - afterEvaluate;
+	cout << "literal expression, " << rounds << " evaluations: PostfixCalculator::Calculate " << calculateTime.count()
+		<< " s, Evaluator::evaluate_numeric " << evaluateTime.count() << " s, bytecode compiled once "
+		<< runTime.count() << " s (checksum " << checksum << ")\n";
+}
+
+// Разбор вида узла: как раньше в executeStatement (shared_ptr по значению +
+// dynamic_pointer_cast), через nodeCast и по дереву в арене
+size_t dispatchDynamic(shared_ptr<Node> node)
+{
+	switch (node->type) {
+		case Node::NodeType::ASSIGNMENT_STATEMENT:
+			return dynamic_pointer_cast<const AssignmentStatementNode>(node)->variableName.size();
+		case Node::NodeType::WRITE_STATEMENT:
+			return dynamic_pointer_cast<const WriteStatementNode>(node)->expression.size();
+		case Node::NodeType::READ_STATEMENT:
+			return dynamic_pointer_cast<const ReadStatementNode>(node)->identifierList != nullptr;
+		case Node::NodeType::IF_STATEMENT:
+			return dynamic_pointer_cast<const IfStatementNode>(node)->thenStatement.size();
+		default:
+			return 0;
+	}
+}
+
+size_t dispatchTagged(const Node* node)
+{
+	switch (node->type) {
+		case Node::NodeType::ASSIGNMENT_STATEMENT:
+			return nodeCast<AssignmentStatementNode>(node)->variableName.size();
+		case Node::NodeType::WRITE_STATEMENT:
+			return nodeCast<WriteStatementNode>(node)->expression.size();
+		case Node::NodeType::READ_STATEMENT:
+			return nodeCast<ReadStatementNode>(node)->identifierList != nullptr;
+		case Node::NodeType::IF_STATEMENT:
+			return nodeCast<IfStatementNode>(node)->thenStatement.size();
+		default:
+			return 0;
+	}
+}
+
+size_t dispatchArena(const Statement* statement)
+{
+	switch (statement->type) {
+		case Node::NodeType::ASSIGNMENT_STATEMENT:
+			return static_cast<const AssignStatement*>(statement)->target.text.size();
+		case Node::NodeType::WRITE_STATEMENT:
+			return static_cast<const WriteStatement*>(statement)->arguments.size();
+		case Node::NodeType::READ_STATEMENT:
+			return static_cast<const ReadStatement*>(statement)->targets.size();
+		case Node::NodeType::IF_STATEMENT:
+			return static_cast<const IfStatement*>(statement)->thenBranch.size();
+		default:
+			return 0;
+	}
+}
+
+void benchmarkDispatch()
+{
+	const int statements = 100000, rounds = 50;
+	string code = "program Dispatch;\nvar a, b: integer;\nbegin\n";
+	for (int i = 0; i < statements / 4; i++)
+		code += "a := b + 1;\nWrite(a, b);\nRead(b);\nif (a > b) then a := b;\n";
+	code += "end.";
+
+	Parser listParser(Lexer(code).tokenize());
+	const list<shared_ptr<Node>>& body = listParser.parse().back();
+	Lexer lexer(code);
+	Parser arenaParser(lexer);
+	Program program = arenaParser.parseProgram();
+
+	size_t checksum = 0;
+	auto start = chrono::high_resolution_clock::now();
+	for (int round = 0; round < rounds; round++)
+		for (const auto& node : body)
+			checksum += dispatchDynamic(node);
+	auto afterDynamic = chrono::high_resolution_clock::now();
+	for (int round = 0; round < rounds; round++)
+		for (const auto& node : body)
+			checksum += dispatchTagged(node.get());
+	auto afterTagged = chrono::high_resolution_clock::now();
+	for (int round = 0; round < rounds; round++)
+		for (const Statement* statement : program.body)
+			checksum += dispatchArena(statement);
+	auto end = chrono::high_resolution_clock::now();
+
+	double count = double(statements) * rounds;
+	chrono::duration<double, nano> dynamicTime = afterDynamic - start;
+	chrono::duration<double, nano> taggedTime = afterTagged - afterDynamic;
+	chrono::duration<double, nano> arenaTime = end - afterTagged;
+	cout << "statement dispatch, ns/statement: dynamic_pointer_cast " << dynamicTime.count() / count
+		<< ", nodeCast " << taggedTime.count() / count << ", arena tag " << arenaTime.count() / count
+		<< " (checksum " << checksum << ")\n";
+}
+
+// аргумент Write со строкой: прежний путь сначала пробовал число и ловил
+// исключение, теперь вычислитель выбирается по типу, выведенному Resolver
+void benchmarkStringWrites()
+{
+	const int rounds = 100000;
+	const string argument = "\"Hello, \" + name + \" and \" + other + \"!\"";
+	Lexer lexer(argument);
+	vector<Token> expression = lexer.tokenize();
+	unordered_map<string, variant<int, double, string>> variables{ { "name", string("Pascal") }, { "other", string("World") } }, constants;
+
+	Lexer programLexer("program Strings;\nvar name, other: string;\nbegin\nWrite(" + argument + ");\nend.");
+	Parser parser(programLexer);
+	Program program = parser.parseProgram();
+	Resolver::resolve(program);
+	const CompiledExpression* typed = ExpressionCompiler::compile(program.arena, static_cast<const WriteStatement*>(program.body[0])->arguments[0]);
+	VariableStorage storage;
+	storage.texts = { "Pascal", "World" };
+	EvaluationContext context(storage);
+
+	size_t checksum = 0;
+	auto start = chrono::high_resolution_clock::now();
+	for (int i = 0; i < rounds; i++) {
+		string record;
+		try {
+			record += to_string(Evaluator::evaluate_numeric(expression, variables, constants));
+		}
+		catch (const exception&) {
+			record += Evaluator::evaluate_string(expression, variables, constants);
+		}
+		checksum += record.size();
+	}
+	auto middle = chrono::high_resolution_clock::now();
+	for (int i = 0; i < rounds; i++) {
+		string record;
+		Evaluator::appendString(*typed, context, record);
+		checksum += record.size();
+	}
+	auto end = chrono::high_resolution_clock::now();
+
+	chrono::duration<double, nano> fallbackTime = middle - start;
+	chrono::duration<double, nano> typedTime = end - middle;
+	cout << "string Write argument, ns/evaluation: numeric then string on exception " << fallbackTime.count() / rounds
+		<< ", typed " << typedTime.count() / rounds << " (checksum " << checksum << ")\n";
+}
+
+// одно и то же выражение при 10 и 1000 объявленных переменных: прежний
+// evaluate_numeric принимал таблицы имён по значению, EvaluationContext
+// ссылается на ячейки, и его цена от числа переменных не зависит
+void benchmarkVariableCount()
+{
+	const int rounds = 20000;
+	for (int declared : { 10, 1000 }) {
+		string code = "program Variables;\nvar ";
+		for (int i = 0; i < declared; i++)
+			code += "v" + to_string(i) + (i + 1 < declared ? ", " : ": integer;\n");
+		code += "begin\nWrite(v0 + v1 * 2 - v2 div 3);\nend.";
+		Lexer lexer(code);
+		Parser parser(lexer);
+		Program program = parser.parseProgram();
+		Resolver::resolve(program);
+		const CompiledExpression* compiled = ExpressionCompiler::compile(program.arena, static_cast<const WriteStatement*>(program.body[0])->arguments[0]);
+		vector<double> stack(compiled->depth);
+
+		VariableStorage storage;
+		unordered_map<string, variant<int, double, string>> variables, constants;
+		for (int i = 0; i < declared; i++) {
+			storage.integers.push_back(i);
+			variables["v" + to_string(i)] = i;
+		}
+		vector<Token> expression = Lexer("v0 + v1 * 2 - v2 div 3").tokenize();
+		EvaluationContext context(storage);
+
+		double checksum = 0;
+		auto start = chrono::high_resolution_clock::now();
+		for (int i = 0; i < rounds; i++)
+			checksum += Evaluator::evaluate_numeric(expression, variables, constants);
+		auto middle = chrono::high_resolution_clock::now();
+		for (int i = 0; i < rounds; i++)
+			checksum += Evaluator::evaluateNumber(*compiled, context, stack.data());
+		auto end = chrono::high_resolution_clock::now();
+
+		chrono::duration<double, nano> legacyTime = middle - start;
+		chrono::duration<double, nano> contextTime = end - middle;
+		cout << declared << " variables declared, ns/evaluation: evaluate_numeric " << legacyTime.count() / rounds
+			<< ", EvaluationContext " << contextTime.count() / rounds << " (checksum " << checksum << ")\n";
+	}
+}
+
+// одно выражение, исполняемое много раз: Expression, собираемый заново
+// при каждом вычислении (как в evaluate_numeric), собранный один раз
+// и байткод, закэшированный на узле
+void benchmarkCompiledExpressions()
+{
+	const int rounds = 200000;
+	const string text = "a * 2 + b / 4 - (a - b) * 3 + a mod 5";
+	vector<Token> expression = Lexer(text).tokenize();
+	map<string, double> values{ { "a", 7 }, { "b", 2.5 } };
+
+	Lexer lexer("program Compiled;\nvar a: integer;\nb: double;\nbegin\nb := " + text + ";\nend.");
+	Parser parser(lexer);
+	Program program = parser.parseProgram();
+	Resolver::resolve(program);
+	Expr* tree = static_cast<const AssignStatement*>(program.body[0])->value;
+	const CompiledExpression* compiled = ExpressionCompiler::compile(program.arena, tree);
+	VariableStorage storage;
+	storage.integers = { 7 };
+	storage.reals = { 2.5 };
+	EvaluationContext context(storage);
+	vector<double> stack(compiled->depth);
+
+	double checksum = 0;
+	auto start = chrono::high_resolution_clock::now();
+	for (int i = 0; i < rounds; i++) {
+		Expression rebuilt(expression);
+		checksum += rebuilt.Calculate(values);
+	}
+	auto afterRebuilt = chrono::high_resolution_clock::now();
+	Expression built(expression);
+	for (int i = 0; i < rounds; i++)
+		checksum += built.Calculate(values);
+	auto afterBuilt = chrono::high_resolution_clock::now();
+	for (int i = 0; i < rounds; i++)
+		checksum += Evaluator::evaluateNumber(*compiled, context, stack.data());
+	auto end = chrono::high_resolution_clock::now();
+
+	chrono::duration<double, nano> rebuiltTime = afterRebuilt - start;
+	chrono::duration<double, nano> builtTime = afterBuilt - afterRebuilt;
+	chrono::duration<double, nano> compiledTime = end - afterBuilt;
+	cout << "repeated expression, ns/evaluation: Expression per evaluation " << rebuiltTime.count() / rounds
+		<< ", Expression built once " << builtTime.count() / rounds
+		<< ", cached bytecode " << compiledTime.count() / rounds << " (checksum " << checksum << ")\n";
+}
 
-int main()
+// сборка выражения из 10 тысяч лексем: три прохода (ExpressionValidator,
+// PostfixConverter, PostfixCalculator::Compile) против одного InfixCompiler
+void benchmarkExpressionCompile()
 {
+	const int rounds = 200;
+	string text = "x";
+	for (int i = 0; i < 2500; i++)
+		text += i % 2 ? " - (y * 2)" : " + z div 3";
+	vector<Token> infix = Lexer(text).tokenize();
+
+	size_t checksum = 0;
+	auto start = chrono::high_resolution_clock::now();
+	for (int i = 0; i < rounds; i++) {
+		vector<Token> validated = infix;
+		ExpressionValidator::Validate(validated);
+		checksum += PostfixCalculator::Compile(PostfixConverter::Convert(validated)).code.size();
+	}
+	auto middle = chrono::high_resolution_clock::now();
+	for (int i = 0; i < rounds; i++)
+		checksum += InfixCompiler::Compile(infix).code.size();
+	auto end = chrono::high_resolution_clock::now();
+
+	chrono::duration<double, micro> separateTime = middle - start;
+	chrono::duration<double, micro> fusedTime = end - middle;
+	cout << infix.size() << "-token expression, us/compile: separate passes " << separateTime.count() / rounds
+		<< ", single pass " << fusedTime.count() / rounds << " (checksum " << checksum << ")\n";
+}
+
+// пропускная способность операторов: одна и та же программа обходом
+// дерева и на виртуальной машине, вывод уходит в строку
+void benchmarkEngines()
+{
+	const int blocks = 2000, rounds = 50;
+	string code = "program Engines;\nvar a, b: integer;\nx: double;\ns: string;\nbegin\n";
+	for (int i = 0; i < blocks; i++)
+		code += "a := a + 3 * b - 1;\nb := a mod 7;\nx := x / 2 + a;\n"
+			"if (a > b) then s := \"p\"; else s := \"q\";\nif (b < 3) then Write(s, a);\n";
+	code += "end.";
+	const double statements = blocks * 5.0 * rounds;
+
+	const pair<ExecutionEngine, const char*> engines[] = {
+		{ ExecutionEngine::TREE, "tree walker" },
+		{ ExecutionEngine::BYTECODE, "bytecode VM" },
+		{ ExecutionEngine::CLOSURES, "closures" },
+	};
+	for (const auto& [engine, name] : engines) {
+		Lexer lexer(code);
+		Parser parser(lexer);
+		Interpreter interpreter(parser.parseProgram());
+		interpreter.setEngine(engine);
+		stringstream sink;
+		streambuf* console = cout.rdbuf(sink.rdbuf());
+		interpreter.run(); // первый run - Resolver и сборка кода
+		auto start = chrono::high_resolution_clock::now();
+		for (int round = 0; round < rounds; round++)
+			interpreter.run();
+		auto end = chrono::high_resolution_clock::now();
+		cout.rdbuf(console);
+
+		chrono::duration<double, nano> time = end - start;
+		cout << name << ": " << time.count() / statements
+			<< " ns/statement (" << sink.str().size() << " bytes written)\n";
+	}
+}
+
+// значения смешанной программы (целые, вещественные, строки): variant - 40 байт
+// и своя копия строки в куче, Value - 16 байт и ссылка на строку в арене.
+// Память, копирование массива значений и сравнение с тем же значением
+void benchmarkValues()
+{
+	const int count = 99840, rounds = 20, distance = 192; // через distance значений - то же значение
+	Arena arena;
+	vector<string_view> words;
+	for (int i = 0; i < 64; i++)
+		words.push_back(arena.copy("string constant number " + to_string(i)));
+
+	vector<variant<int, double, string>> variants;
+	vector<Value> values;
+	for (int i = 0; i < count; i++) {
+		int base = i % distance;
+		switch (i % 3) {
+		case 0: variants.emplace_back(base); values.push_back(Value::fromInteger(base)); break;
+		case 1: variants.emplace_back(base * 0.5); values.push_back(Value::fromReal(base * 0.5)); break;
+		default:
+			variants.emplace_back(string(words[base % words.size()]));
+			values.push_back(Value::fromText(words[base % words.size()]));
+			break;
+		}
+	}
+	size_t variantBytes = variants.size() * sizeof(variants[0]);
+	for (const auto& value : variants) {
+		const string* text = get_if<string>(&value);
+		if (text && text->capacity() > 15) // длиннее буфера короткой строки
+			variantBytes += text->capacity() + 1;
+	}
+	size_t valueBytes = values.size() * sizeof(Value);
+	for (string_view word : words)
+		valueBytes += word.size();
+
+	size_t equal = 0;
+	auto start = chrono::high_resolution_clock::now();
+	for (int round = 0; round < rounds; round++) {
+		vector<variant<int, double, string>> copy = variants;
+		for (size_t i = distance; i < copy.size(); i++)
+			equal += copy[i] == copy[i - distance];
+	}
+	auto middle = chrono::high_resolution_clock::now();
+	for (int round = 0; round < rounds; round++) {
+		vector<Value> copy = values;
+		for (size_t i = distance; i < copy.size(); i++)
+			equal += copy[i] == copy[i - distance];
+	}
+	auto end = chrono::high_resolution_clock::now();
+
+	chrono::duration<double, nano> variantTime = middle - start;
+	chrono::duration<double, nano> valueTime = end - middle;
+	cout << count << " mixed values, bytes: variant " << variantBytes << ", Value " << valueBytes
+		<< "; ns/value copy and compare: variant " << variantTime.count() / (double(count) * rounds)
+		<< ", Value " << valueTime.count() / (double(count) * rounds) << " (equal " << equal << ")\n";
+}
+
+// одно выражение над целыми переменными (код int64 с проверкой переполнения)
+// и над вещественными (код double с floor и fmod для div и mod)
+void benchmarkIntegerExpressions()
+{
+	const int rounds = 1000000;
+	const string text = "a * 3 + b div 7 - a mod 5 + b * b div 11";
+	double checksum = 0, times[2];
+	for (int typed = 0; typed < 2; typed++) {
+		const char* type = typed == 0 ? "integer" : "double";
+		Lexer lexer("program Integers;\nvar a, b: " + string(type) + ";\nbegin\nWrite(" + text + ");\nend.");
+		Parser parser(lexer);
+		Program program = parser.parseProgram();
+		Resolver::resolve(program);
+		Expr* tree = static_cast<const WriteStatement*>(program.body[0])->arguments[0];
+		const CompiledExpression* compiled = ExpressionCompiler::compile(program.arena, tree);
+		VariableStorage storage;
+		storage.reset(program.variables);
+		EvaluationContext context(storage);
+		vector<double> stack(compiled->depth);
+
+		auto start = chrono::high_resolution_clock::now();
+		for (int i = 0; i < rounds; i++) {
+			if (compiled->type == ValueType::INTEGER) {
+				storage.integers[0] = i;
+				storage.integers[1] = i + 7;
+			}
+			else {
+				storage.reals[0] = i;
+				storage.reals[1] = i + 7;
+			}
+			checksum += Evaluator::evaluateNumber(*compiled, context, stack.data());
+		}
+		auto end = chrono::high_resolution_clock::now();
+
+		times[typed] = chrono::duration<double, nano>(end - start).count() / rounds;
+	}
+	cout << "integer expression, ns/evaluation: int64 code " << times[0] << ", same on double variables " << times[1]
+		<< " (checksum " << checksum << ")\n";
+}
+
+void runBenchmarks()
+{
+	benchmarkLiterals();
+	benchmarkDispatch();
+	benchmarkStringWrites();
+	benchmarkVariableCount();
+	benchmarkCompiledExpressions();
+	benchmarkIntegerExpressions();
+	benchmarkExpressionCompile();
+	benchmarkEngines();
+	benchmarkValues();
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1 && string(argv[1]) == "--bench") {
+		runBenchmarks();
+		return 0;
+	}
+
+	if (argc > 1) {
+		return runFile(argv[1]);
+	}
+
 	try {
 		string code = R"(program Example; 
 						const 
@@ -23,13 +476,13 @@ int main()
 							num1 := a + b - c;
 							num2 := 2;
 							num3 := num1;
-							Write("   : ", num1, num2, REs);
+							Write("Введите чётное целое число: ", num1, num2, REs);
 							RESULT := Pi;
 							Read(num3, num1);
 							Write(RESULT);
 							if (b mod 2) then
 							begin
-								Write(" = ", Res);
+								Write("Результат = ", Res);
 								if (a / b) then 
 								begin
 									a := b;
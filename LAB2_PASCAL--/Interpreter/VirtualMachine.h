@@ -0,0 +1,265 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+#include "BytecodeCompiler.h"
+#include "Console.h"
+#include "../ExpressionEvaluator/IntegerArithmetic.h"
+
+using namespace std;
+
+// Переход к следующей команде: в GCC и Clang - по таблице адресов меток
+// (computed goto), в остальных компиляторах - обычный switch.
+// PASCAL_VM_SWITCH_DISPATCH включает switch и там.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(PASCAL_VM_SWITCH_DISPATCH)
+#define PASCAL_VM_COMPUTED_GOTO 1
+#else
+#define PASCAL_VM_COMPUTED_GOTO 0
+#endif
+
+// Исполнение кода BytecodeCompiler над ячейками переменных интерпретатора
+class VirtualMachine {
+private:
+    template <typename T>
+    static T read(const uint8_t*& pc) {
+        T value;
+        memcpy(&value, pc, sizeof(T));
+        pc += sizeof(T);
+        return value;
+    }
+
+    [[noreturn]] static void fail(const ProgramCode& program, uint32_t context, const char* message) {
+        throw runtime_error(program.contexts[context] + message);
+    }
+
+    // целая операция над двумя верхними ячейками; переполнение и деление
+    // на 0 получают начало сообщения context
+    template <typename Operation>
+    static void integer(const ProgramCode& program, uint32_t context, double*& top, Operation operation) {
+        top--;
+        try {
+            IntegerArithmetic::store(top - 1, operation(IntegerArithmetic::load(top - 1), IntegerArithmetic::load(top)));
+        }
+        catch (const runtime_error& exc) {
+            fail(program, context, exc.what());
+        }
+    }
+
+public:
+    static void run(const ProgramCode& program, VariableStorage& storage) {
+        vector<double> numbers(program.depth + 1);
+        double* top = numbers.data();
+        string text;   // аккумулятор строк и строки вывода
+        string saved;  // левая часть сравнения строк
+        const uint8_t* const start = program.code.data();
+        const uint8_t* pc = start;
+
+#if PASCAL_VM_COMPUTED_GOTO
+        static void* const labels[] = {
+            &&op_NUMBER, &&op_LOAD_INTEGER, &&op_LOAD_DOUBLE, &&op_NEGATE, &&op_ADD, &&op_SUBTRACT,
+            &&op_MULTIPLY, &&op_DIVIDE, &&op_DIV, &&op_MOD, &&op_INTEGER_NUMBER, &&op_INTEGER_LOAD,
+            &&op_INTEGER_NEGATE, &&op_INTEGER_ADD, &&op_INTEGER_SUBTRACT, &&op_INTEGER_MULTIPLY,
+            &&op_INTEGER_DIV, &&op_INTEGER_MOD, &&op_TO_DOUBLE, &&op_STORE_INTEGER, &&op_STORE_DOUBLE,
+            &&op_INTEGER_STORE, &&op_TEXT, &&op_TEXT_VARIABLE, &&op_STORE_TEXT, &&op_SAVE_TEXT,
+            &&op_WRITE_NUMBER, &&op_WRITE_INTEGER, &&op_WRITE_LINE, &&op_READ, &&op_JUMP,
+            &&op_JUMP_UNLESS_EQUAL, &&op_JUMP_UNLESS_NON_EQUAL, &&op_JUMP_UNLESS_LESS,
+            &&op_JUMP_UNLESS_GREATER, &&op_JUMP_UNLESS_LESS_OR_EQUAL, &&op_JUMP_UNLESS_GREATER_OR_EQUAL,
+            &&op_JUMP_UNLESS_INTEGER_EQUAL, &&op_JUMP_UNLESS_INTEGER_NON_EQUAL, &&op_JUMP_UNLESS_INTEGER_LESS,
+            &&op_JUMP_UNLESS_INTEGER_GREATER, &&op_JUMP_UNLESS_INTEGER_LESS_OR_EQUAL,
+            &&op_JUMP_UNLESS_INTEGER_GREATER_OR_EQUAL, &&op_JUMP_UNLESS_TEXT_EQUAL,
+            &&op_JUMP_UNLESS_TEXT_NON_EQUAL, &&op_HALT
+        };
+        static_assert(sizeof(labels) / sizeof(labels[0]) == vmOpCount, "every VmOp needs a label");
+#define VM_CASE(name) op_##name
+#define VM_NEXT() goto *labels[*pc++]
+        VM_NEXT();
+#else
+#define VM_CASE(name) case VmOp::name
+#define VM_NEXT() goto dispatch
+    dispatch:
+        switch (VmOp(*pc++)) {
+#endif
+        VM_CASE(NUMBER):
+            *top++ = read<double>(pc);
+            VM_NEXT();
+        VM_CASE(LOAD_INTEGER):
+            *top++ = storage.integers[read<uint32_t>(pc)];
+            VM_NEXT();
+        VM_CASE(LOAD_DOUBLE):
+            *top++ = storage.reals[read<uint32_t>(pc)];
+            VM_NEXT();
+        VM_CASE(NEGATE):
+            top[-1] = -top[-1];
+            VM_NEXT();
+        VM_CASE(ADD):
+            top--;
+            top[-1] += *top;
+            VM_NEXT();
+        VM_CASE(SUBTRACT):
+            top--;
+            top[-1] -= *top;
+            VM_NEXT();
+        VM_CASE(MULTIPLY):
+            top--;
+            top[-1] *= *top;
+            VM_NEXT();
+        VM_CASE(DIVIDE): {
+            uint32_t context = read<uint32_t>(pc);
+            top--;
+            if (*top == 0.0) fail(program, context, "Division by zero");
+            top[-1] /= *top;
+            VM_NEXT();
+        }
+        VM_CASE(DIV): {
+            uint32_t context = read<uint32_t>(pc);
+            top--;
+            if (*top == 0.0) fail(program, context, "Integer division by zero");
+            top[-1] = floor(top[-1] / *top);
+            VM_NEXT();
+        }
+        VM_CASE(MOD): {
+            uint32_t context = read<uint32_t>(pc);
+            top--;
+            if (*top == 0.0) fail(program, context, "Modulo by zero");
+            top[-1] = fmod(top[-1], *top);
+            VM_NEXT();
+        }
+        VM_CASE(INTEGER_NUMBER):
+            IntegerArithmetic::store(top++, read<int64_t>(pc));
+            VM_NEXT();
+        VM_CASE(INTEGER_LOAD):
+            IntegerArithmetic::store(top++, storage.integers[read<uint32_t>(pc)]);
+            VM_NEXT();
+        VM_CASE(INTEGER_NEGATE): {
+            uint32_t context = read<uint32_t>(pc);
+            int64_t value = IntegerArithmetic::load(top - 1);
+            if (value == INT64_MIN) fail(program, context, "Integer overflow");
+            IntegerArithmetic::store(top - 1, -value);
+            VM_NEXT();
+        }
+        VM_CASE(INTEGER_ADD):
+            integer(program, read<uint32_t>(pc), top, IntegerArithmetic::add);
+            VM_NEXT();
+        VM_CASE(INTEGER_SUBTRACT):
+            integer(program, read<uint32_t>(pc), top, IntegerArithmetic::subtract);
+            VM_NEXT();
+        VM_CASE(INTEGER_MULTIPLY):
+            integer(program, read<uint32_t>(pc), top, IntegerArithmetic::multiply);
+            VM_NEXT();
+        VM_CASE(INTEGER_DIV):
+            integer(program, read<uint32_t>(pc), top, IntegerArithmetic::div);
+            VM_NEXT();
+        VM_CASE(INTEGER_MOD):
+            integer(program, read<uint32_t>(pc), top, IntegerArithmetic::mod);
+            VM_NEXT();
+        VM_CASE(TO_DOUBLE):
+            top[-1] = static_cast<double>(IntegerArithmetic::load(top - 1));
+            VM_NEXT();
+        VM_CASE(STORE_INTEGER): {
+            uint32_t slot = read<uint32_t>(pc);
+            uint32_t context = read<uint32_t>(pc);
+            double value = *--top;
+            if (!(value > numeric_limits<int>::min() - 1.0 && value < numeric_limits<int>::max() + 1.0))
+                fail(program, context, "Integer overflow");
+            storage.integers[slot] = static_cast<int>(value);
+            VM_NEXT();
+        }
+        VM_CASE(STORE_DOUBLE):
+            storage.reals[read<uint32_t>(pc)] = *--top;
+            VM_NEXT();
+        VM_CASE(INTEGER_STORE): {
+            uint32_t slot = read<uint32_t>(pc);
+            uint32_t context = read<uint32_t>(pc);
+            int64_t value = IntegerArithmetic::load(--top);
+            if (value < numeric_limits<int>::min() || value > numeric_limits<int>::max())
+                fail(program, context, "Integer overflow");
+            storage.integers[slot] = static_cast<int>(value);
+            VM_NEXT();
+        }
+        VM_CASE(TEXT):
+            text += program.texts[read<uint32_t>(pc)];
+            VM_NEXT();
+        VM_CASE(TEXT_VARIABLE):
+            text += storage.texts[read<uint32_t>(pc)];
+            VM_NEXT();
+        VM_CASE(STORE_TEXT):
+            // выражение могло читать ту же ячейку: значение собрано в text
+            storage.texts[read<uint32_t>(pc)].swap(text);
+            text.clear();
+            VM_NEXT();
+        VM_CASE(SAVE_TEXT):
+            saved.swap(text);
+            text.clear();
+            VM_NEXT();
+        VM_CASE(WRITE_NUMBER):
+            text += num_to_str(*--top);
+            VM_NEXT();
+        VM_CASE(WRITE_INTEGER):
+            text += to_string(IntegerArithmetic::load(--top));
+            VM_NEXT();
+        VM_CASE(WRITE_LINE):
+            cout << text << '\n';
+            text.clear();
+            VM_NEXT();
+        VM_CASE(READ):
+            read_variable(storage, program.reads[read<uint32_t>(pc)]);
+            VM_NEXT();
+        VM_CASE(JUMP):
+            pc = start + read<uint32_t>(pc);
+            VM_NEXT();
+
+#define VM_JUMP_UNLESS(name, comparison) \
+        VM_CASE(name): { \
+            uint32_t target = read<uint32_t>(pc); \
+            top -= 2; \
+            if (!(top[0] comparison top[1])) pc = start + target; \
+            VM_NEXT(); \
+        }
+        VM_JUMP_UNLESS(JUMP_UNLESS_EQUAL, ==)
+        VM_JUMP_UNLESS(JUMP_UNLESS_NON_EQUAL, !=)
+        VM_JUMP_UNLESS(JUMP_UNLESS_LESS, <)
+        VM_JUMP_UNLESS(JUMP_UNLESS_GREATER, >)
+        VM_JUMP_UNLESS(JUMP_UNLESS_LESS_OR_EQUAL, <=)
+        VM_JUMP_UNLESS(JUMP_UNLESS_GREATER_OR_EQUAL, >=)
+
+#define VM_JUMP_UNLESS_INTEGER(name, comparison) \
+        VM_CASE(name): { \
+            uint32_t target = read<uint32_t>(pc); \
+            top -= 2; \
+            if (!(IntegerArithmetic::load(top) comparison IntegerArithmetic::load(top + 1))) pc = start + target; \
+            VM_NEXT(); \
+        }
+        VM_JUMP_UNLESS_INTEGER(JUMP_UNLESS_INTEGER_EQUAL, ==)
+        VM_JUMP_UNLESS_INTEGER(JUMP_UNLESS_INTEGER_NON_EQUAL, !=)
+        VM_JUMP_UNLESS_INTEGER(JUMP_UNLESS_INTEGER_LESS, <)
+        VM_JUMP_UNLESS_INTEGER(JUMP_UNLESS_INTEGER_GREATER, >)
+        VM_JUMP_UNLESS_INTEGER(JUMP_UNLESS_INTEGER_LESS_OR_EQUAL, <=)
+        VM_JUMP_UNLESS_INTEGER(JUMP_UNLESS_INTEGER_GREATER_OR_EQUAL, >=)
+#undef VM_JUMP_UNLESS_INTEGER
+#undef VM_JUMP_UNLESS
+
+        VM_CASE(JUMP_UNLESS_TEXT_EQUAL): {
+            uint32_t target = read<uint32_t>(pc);
+            if (saved != text) pc = start + target;
+            text.clear();
+            VM_NEXT();
+        }
+        VM_CASE(JUMP_UNLESS_TEXT_NON_EQUAL): {
+            uint32_t target = read<uint32_t>(pc);
+            if (saved == text) pc = start + target;
+            text.clear();
+            VM_NEXT();
+        }
+        VM_CASE(HALT):
+            return;
+#if !PASCAL_VM_COMPUTED_GOTO
+        }
+#endif
+#undef VM_CASE
+#undef VM_NEXT
+    }
+};
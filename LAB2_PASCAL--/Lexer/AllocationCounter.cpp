@@ -0,0 +1,40 @@
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+// Заменены все обычные формы new и delete (массивы, с размером, nothrow),
+// так что любая пара выделения и освобождения идёт через malloc и free
+static size_t allocations = 0;
+
+size_t allocationCount() {
+    return allocations;
+}
+
+static void* countedAllocate(size_t size) noexcept {
+    allocations++;
+    return malloc(size ? size : 1);
+}
+
+void* operator new(size_t size) {
+    if (void* ptr = countedAllocate(size))
+        return ptr;
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    if (void* ptr = countedAllocate(size))
+        return ptr;
+    throw bad_alloc();
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept { return countedAllocate(size); }
+void* operator new[](size_t size, const nothrow_t&) noexcept { return countedAllocate(size); }
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+void operator delete(void* ptr, const nothrow_t&) noexcept { free(ptr); }
+void operator delete[](void* ptr, const nothrow_t&) noexcept { free(ptr); }
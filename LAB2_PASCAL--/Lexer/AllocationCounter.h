@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+
+// Число выделений памяти через operator new с начала программы - для
+// бенчмарков лексера. Замена new и delete лежит в AllocationCounter.cpp,
+// отдельно от кода, который измеряется: иначе компилятор встраивает её
+// в вызывающие функции и путает пары выделения и освобождения.
+size_t allocationCount();
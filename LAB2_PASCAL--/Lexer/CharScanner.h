@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LEXER_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LEXER_SIMD_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+// Поиск конца серии пробелов, идентификатора или цифр сразу по 16/32 байта.
+// Каждая функция возвращает позицию первого символа, не входящего в серию.
+class CharScanner {
+private:
+    enum class CharClass { SPACE, IDENTIFIER, DIGIT };
+
+    static unsigned lowestBit(uint32_t mask) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return index;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    static unsigned highestBit(uint32_t mask) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse(&index, mask);
+        return index;
+#else
+        return 31 - __builtin_clz(mask);
+#endif
+    }
+
+    static unsigned bitCount(uint32_t mask) {
+        mask = mask - ((mask >> 1) & 0x55555555u);
+        mask = (mask & 0x33333333u) + ((mask >> 2) & 0x33333333u);
+        return (((mask + (mask >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+    }
+
+    // isspace() в локали "C": ' ', '\t', '\n', '\v', '\f', '\r'
+    static bool isSpace(unsigned char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+    static bool isDigit(unsigned char c) { return c >= '0' && c <= '9'; }
+    static bool isIdentifier(unsigned char c) { return isDigit(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c == '_'; }
+
+    static bool matches(CharClass cls, unsigned char c) {
+        switch (cls) {
+        case CharClass::SPACE: return isSpace(c);
+        case CharClass::IDENTIFIER: return isIdentifier(c);
+        default: return isDigit(c);
+        }
+    }
+
+#if defined(LEXER_SIMD_AVX2)
+    static const size_t BLOCK = 32;
+    using Vector = __m256i;
+
+    static Vector load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const Vector*>(p)); }
+    static Vector splat(char c) { return _mm256_set1_epi8(c); }
+    static Vector equal(Vector a, Vector b) { return _mm256_cmpeq_epi8(a, b); }
+    static Vector either(Vector a, Vector b) { return _mm256_or_si256(a, b); }
+    static uint32_t toMask(Vector v) { return static_cast<uint32_t>(_mm256_movemask_epi8(v)); }
+    static uint32_t fullMask() { return 0xFFFFFFFFu; }
+    // from <= c <= to без знака: (c - from) <= (to - from)
+    static Vector inRange(Vector v, char from, char to) {
+        Vector shifted = _mm256_sub_epi8(v, splat(from));
+        return equal(_mm256_min_epu8(shifted, splat(char(to - from))), shifted);
+    }
+#elif defined(LEXER_SIMD_SSE2)
+    static const size_t BLOCK = 16;
+    using Vector = __m128i;
+
+    static Vector load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const Vector*>(p)); }
+    static Vector splat(char c) { return _mm_set1_epi8(c); }
+    static Vector equal(Vector a, Vector b) { return _mm_cmpeq_epi8(a, b); }
+    static Vector either(Vector a, Vector b) { return _mm_or_si128(a, b); }
+    static uint32_t toMask(Vector v) { return static_cast<uint32_t>(_mm_movemask_epi8(v)); }
+    static uint32_t fullMask() { return 0xFFFFu; }
+    static Vector inRange(Vector v, char from, char to) {
+        Vector shifted = _mm_sub_epi8(v, splat(from));
+        return equal(_mm_min_epu8(shifted, splat(char(to - from))), shifted);
+    }
+#endif
+
+#if defined(LEXER_SIMD_AVX2) || defined(LEXER_SIMD_SSE2)
+    static uint32_t classMask(CharClass cls, Vector v) {
+        switch (cls) {
+        case CharClass::SPACE:
+            return toMask(either(equal(v, splat(' ')), inRange(v, '\t', '\r')));
+        case CharClass::IDENTIFIER:
+            return toMask(either(either(inRange(either(v, splat(0x20)), 'a', 'z'), inRange(v, '0', '9')), equal(v, splat('_'))));
+        default:
+            return toMask(inRange(v, '0', '9'));
+        }
+    }
+#endif
+
+    static size_t scan(CharClass cls, const char* data, size_t pos, size_t size) {
+#if defined(LEXER_SIMD_AVX2) || defined(LEXER_SIMD_SSE2)
+        while (pos + BLOCK <= size) {
+            uint32_t stop = ~classMask(cls, load(data + pos)) & fullMask();
+            if (stop) {
+                return pos + lowestBit(stop);
+            }
+            pos += BLOCK;
+        }
+#endif
+        while (pos < size && matches(cls, static_cast<unsigned char>(data[pos]))) {
+            pos++;
+        }
+        return pos;
+    }
+
+public:
+    static size_t skipIdentifier(const char* data, size_t pos, size_t size) {
+        return scan(CharClass::IDENTIFIER, data, pos, size);
+    }
+
+    static size_t skipDigits(const char* data, size_t pos, size_t size) {
+        return scan(CharClass::DIGIT, data, pos, size);
+    }
+
+    // Пропускает пробельные символы, попутно считая переводы строк:
+    // newlines - их число, lastNewline - позиция последнего из них
+    static size_t skipSpaces(const char* data, size_t pos, size_t size, int& newlines, size_t& lastNewline) {
+        newlines = 0;
+#if defined(LEXER_SIMD_AVX2) || defined(LEXER_SIMD_SSE2)
+        while (pos + BLOCK <= size) {
+            Vector block = load(data + pos);
+            uint32_t stop = ~classMask(CharClass::SPACE, block) & fullMask();
+            uint32_t lines = toMask(equal(block, splat('\n')));
+            if (stop) {
+                lines &= (1u << lowestBit(stop)) - 1;
+            }
+            if (lines) {
+                newlines += bitCount(lines);
+                lastNewline = pos + highestBit(lines);
+            }
+            if (stop) {
+                return pos + lowestBit(stop);
+            }
+            pos += BLOCK;
+        }
+#endif
+        while (pos < size && isSpace(static_cast<unsigned char>(data[pos]))) {
+            if (data[pos] == '\n') {
+                newlines++;
+                lastNewline = pos;
+            }
+            pos++;
+        }
+        return pos;
+    }
+};
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <stdexcept>
+#include "Lexer.h"
+
+using namespace std;
+
+// Правка текста: с позиции offset удалить removed байт и вставить inserted
+struct TextEdit {
+    size_t offset = 0;
+    size_t removed = 0;
+    string inserted;
+};
+
+// Изменённый участок массива лексем: лексемы [first, first + removed)
+// старого массива заменены на [first, first + inserted) нового
+struct TokenRange {
+    size_t first = 0;
+    size_t removed = 0;
+    size_t inserted = 0;
+};
+
+// Лексер для редактора: хранит текст и его лексемы и после каждой правки
+// заново разбирает только участок от последней лексемы перед правкой до
+// места, где новые лексемы снова совпадают со старыми.
+class IncrementalLexer {
+private:
+    // буфер без владения: лексер читает прямо из text
+    class TextView : public SourceBuffer {
+    public:
+        explicit TextView(string_view source) { contents = source; }
+    };
+
+    string text;
+    LexerEngine engine;
+    shared_ptr<SymbolTable> symbolTable = make_shared<SymbolTable>(); // номера имён не меняются от правки к правке
+    vector<Token> tokenList;
+    // Байтовые границы лексем (строки - вместе с кавычками). Лексемы до gap
+    // хранят смещение от начала текста, начиная с gap - расстояние до конца
+    // текста: тогда правка перед ними ничего в хвосте не сдвигает.
+    vector<size_t> starts;
+    vector<size_t> ends;
+    size_t gap = 0;
+
+    size_t startAt(size_t index) const { return index < gap ? starts[index] : text.size() - starts[index]; }
+    size_t endAt(size_t index) const { return index < gap ? ends[index] : text.size() - ends[index]; }
+
+    // переносит границу gap, переводя смещения лексем между старым и новым местом
+    void moveGap(size_t to) {
+        for (; gap < to; gap++) {
+            starts[gap] = text.size() - starts[gap];
+            ends[gap] = text.size() - ends[gap];
+        }
+        while (gap > to) {
+            gap--;
+            starts[gap] = text.size() - starts[gap];
+            ends[gap] = text.size() - ends[gap];
+        }
+    }
+
+    // первая лексема, которая кончается не раньше offset
+    size_t firstEndingAtOrAfter(size_t offset) const {
+        size_t low = 0, high = tokenList.size();
+        while (low < high) {
+            size_t middle = (low + high) / 2;
+            if (endAt(middle) < offset) {
+                low = middle + 1;
+            }
+            else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+    size_t startOf(const TokenView& view) const {
+        size_t start = size_t(view.lexeme.data() - text.data());
+        return view.type == TokenTypes::STRING_LITERAL ? start - 1 : start;
+    }
+
+    size_t endOf(const TokenView& view) const {
+        size_t end = size_t(view.lexeme.data() - text.data()) + view.lexeme.size();
+        return view.type == TokenTypes::STRING_LITERAL ? end + 1 : end;
+    }
+
+    // лексер, продолжающий разбор с позиции сразу после лексемы index - 1
+    Lexer resumeAfter(const shared_ptr<const SourceBuffer>& buffer, size_t index) const {
+        Lexer lexer(buffer, engine);
+        lexer.shareSymbols(symbolTable);
+        if (index > 0) {
+            const Token& previous = tokenList[index - 1];
+            lexer.curPos = endAt(index - 1);
+            lexer.curLine = previous.line;
+            // внутри лексемы номер строки не меняется, а колонка растёт на каждый байт
+            lexer.curColumn = previous.column - 1 + int(endAt(index - 1) - startAt(index - 1));
+        }
+        return lexer;
+    }
+
+public:
+    explicit IncrementalLexer(string source, LexerEngine lexerEngine = LexerEngine::SWITCH)
+        : text(move(source)), engine(lexerEngine) {
+        Lexer lexer(make_shared<const TextView>(text), engine);
+        lexer.shareSymbols(symbolTable);
+        optional<TokenView> view;
+        while ((view = lexer.nextView()).has_value()) {
+            tokenList.push_back(view->toToken());
+            starts.push_back(startOf(*view));
+            ends.push_back(endOf(*view));
+        }
+        gap = tokenList.size();
+    }
+
+    shared_ptr<const SymbolTable> symbols() const {
+        return symbolTable;
+    }
+
+    const string& source() const {
+        return text;
+    }
+
+    // совпадает с Lexer(source()).tokenize()
+    const vector<Token>& tokens() const {
+        return tokenList;
+    }
+
+    // Применяет правку и возвращает изменённый участок массива tokens().
+    // Разбирается только участок около правки; хвост массива сдвигается,
+    // лишь если меняется число лексем или строк.
+    // При лексической ошибке текст и лексемы остаются прежними.
+    TokenRange apply(const TextEdit& edit) {
+        if (edit.offset > text.size() || edit.removed > text.size() - edit.offset) {
+            throw out_of_range("Error: Edit is outside of the source text");
+        }
+        // первая лексема, которую правка может задеть: она кончается не раньше
+        // начала правки (лексема вплотную к правке может с ней слиться)
+        const size_t first = firstEndingAtOrAfter(edit.offset);
+        const size_t oldCount = tokenList.size();
+        moveGap(first);
+
+        const size_t oldEditEnd = edit.offset + edit.removed;
+        const size_t newEditEnd = edit.offset + edit.inserted.size();
+        const size_t oldSize = text.size();
+        string removedText = text.substr(edit.offset, edit.removed);
+        text.replace(edit.offset, edit.removed, edit.inserted);
+
+        vector<Token> fresh;
+        vector<size_t> freshStarts, freshEnds;
+        size_t next = first;
+        bool synced = false;
+        int lineDelta = 0, columnDelta = 0, syncLine = 0;
+        try {
+            Lexer lexer = resumeAfter(make_shared<const TextView>(text), first);
+            optional<TokenView> view;
+            while ((view = lexer.nextView()).has_value()) {
+                size_t start = startOf(*view);
+                size_t end = endOf(*view);
+                // после правки поток снова совпадает со старым, как только
+                // лексема за правкой стоит на своём прежнем (сдвинутом) месте;
+                // у лексем после gap расстояние до конца текста не меняется
+                if (start >= newEditEnd) {
+                    while (next < oldCount && (oldSize - starts[next] < oldEditEnd || text.size() - starts[next] < start)) {
+                        next++;
+                    }
+                    if (next < oldCount && text.size() - starts[next] == start && text.size() - ends[next] == end
+                        && tokenList[next].type == view->type) {
+                        lineDelta = view->line - tokenList[next].line;
+                        columnDelta = view->column - tokenList[next].column;
+                        syncLine = tokenList[next].line;
+                        synced = true;
+                        break;
+                    }
+                }
+                fresh.push_back(view->toToken());
+                freshStarts.push_back(text.size() - start);
+                freshEnds.push_back(text.size() - end);
+            }
+        }
+        catch (...) {
+            text.replace(edit.offset, edit.inserted.size(), removedText);
+            throw;
+        }
+        if (!synced) {
+            next = oldCount;
+        }
+
+        // колонки меняются только на строке точки совпадения, номера строк -
+        // только если правка добавила или убрала перевод строки
+        for (size_t i = next; i < oldCount && (lineDelta != 0 || tokenList[i].line == syncLine); i++) {
+            if (tokenList[i].line == syncLine) {
+                tokenList[i].column += columnDelta;
+            }
+            tokenList[i].line += lineDelta;
+        }
+
+        const size_t removed = next - first;
+        if (fresh.size() == removed) {
+            move(fresh.begin(), fresh.end(), tokenList.begin() + first);
+            copy(freshStarts.begin(), freshStarts.end(), starts.begin() + first);
+            copy(freshEnds.begin(), freshEnds.end(), ends.begin() + first);
+        }
+        else {
+            tokenList.erase(tokenList.begin() + first, tokenList.begin() + next);
+            tokenList.insert(tokenList.begin() + first, make_move_iterator(fresh.begin()), make_move_iterator(fresh.end()));
+            starts.erase(starts.begin() + first, starts.begin() + next);
+            starts.insert(starts.begin() + first, freshStarts.begin(), freshStarts.end());
+            ends.erase(ends.begin() + first, ends.begin() + next);
+            ends.insert(ends.begin() + first, freshEnds.begin(), freshEnds.end());
+        }
+        return TokenRange{ first, removed, fresh.size() };
+    }
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <string_view>
+#include "../Base/Token.h"
+
+using namespace std;
+
+struct Keyword {
+    string_view text;
+    TokenTypes type = TokenTypes::UNKNOWN;
+};
+
+constexpr Keyword keywordList[] = {
+    { "program", TokenTypes::KEYWORD_PROGRAM },
+    { "const", TokenTypes::KEYWORD_CONST },
+    { "var", TokenTypes::KEYWORD_VAR },
+    { "begin", TokenTypes::KEYWORD_BEGIN },
+    { "end", TokenTypes::KEYWORD_END },
+    { "if", TokenTypes::KEYWORD_IF },
+    { "then", TokenTypes::KEYWORD_THEN },
+    { "else", TokenTypes::KEYWORD_ELSE },
+    { "mod", TokenTypes::KEYWORD_MOD },
+    { "div", TokenTypes::KEYWORD_DIV },
+    { "integer", TokenTypes::KEYWORD_INTEGER },
+    { "double", TokenTypes::KEYWORD_DOUBLE },
+    { "string", TokenTypes::KEYWORD_STRING },
+    { "Write", TokenTypes::KEYWORD_WRITE },
+    { "Read", TokenTypes::KEYWORD_READ }
+};
+
+constexpr size_t keywordTableSize = 32;
+
+// первый символ + последний символ + длина: на этом наборе ключевых слов коллизий нет
+constexpr size_t keywordHash(string_view lexeme) {
+    return (static_cast<unsigned char>(lexeme.front()) + static_cast<unsigned char>(lexeme.back()) + lexeme.size()) % keywordTableSize;
+}
+
+constexpr array<Keyword, keywordTableSize> buildKeywordTable() {
+    array<Keyword, keywordTableSize> table{};
+    for (const Keyword& keyword : keywordList) {
+        table[keywordHash(keyword.text)] = keyword;
+    }
+    return table;
+}
+
+constexpr array<Keyword, keywordTableSize> keywordTable = buildKeywordTable();
+
+constexpr bool isKeywordHashPerfect() {
+    size_t used = 0;
+    for (const Keyword& slot : keywordTable) {
+        if (!slot.text.empty()) used++;
+    }
+    return used == sizeof(keywordList) / sizeof(keywordList[0]);
+}
+
+static_assert(isKeywordHashPerfect(), "keywordHash has collisions, change the hash or keywordTableSize");
+
+// один хеш и одно сравнение строк; для обычного идентификатора возвращает UNKNOWN
+constexpr TokenTypes findKeyword(string_view lexeme) {
+    if (lexeme.size() < 2 || lexeme.size() > 7) {
+        return TokenTypes::UNKNOWN;
+    }
+    const Keyword& slot = keywordTable[keywordHash(lexeme)];
+    return slot.text == lexeme ? slot.type : TokenTypes::UNKNOWN;
+}
@@ -2,90 +2,192 @@
 
 #include <vector>
 #include "../Base/Token.h"
+#include "../Base/SourceBuffer.h"
+#include "../Base/TokenBuffer.h"
+#include "../Base/SymbolTable.h"
+#include "Keywords.h"
+#include "CharScanner.h"
+#include "LexerTables.h"
 #include <string>
+#include <string_view>
+#include <memory>
 #include <cctype>
 #include <variant>
 #include <optional>
 #include <iostream>
 #include <stdexcept>
+#include <iterator>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 
 using namespace std;
 
 enum class LexerState {
-    START,            //  
-    IDENTIFIER,       //   
-    INTEGER,          //   
-    DOUBLE,           //     
-    STRING,           //  
-    ASSIGN,           // c  ':'
-    GREATER_THAN,     //   '>'
-    LESS_THAN         //   '<'
+    START,            // стартовое состояние
+    IDENTIFIER,       // обработка имён переменных
+    INTEGER,          // обработка целых чисел
+    DOUBLE,           // обработка чисел с плавающей точкой
+    STRING,           // обработка строк
+    ASSIGN,           // cостояние после ':'
+    GREATER_THAN,     // состояние после '>'
+    LESS_THAN         // состояние после '<'
+};
+
+enum class LexerEngine {
+    SWITCH,           // конечный автомат на switch по LexerState
+    TABLE             // автомат на таблицах переходов из LexerTables.h
 };
 
 class Lexer {
+    friend class IncrementalLexer;
+
 private:
-    string sourceCode;
-    int curPos;
+    shared_ptr<const SourceBuffer> buffer;
+    string_view sourceCode;
+    size_t curPos;
     int curLine;
     int curColumn;
 
-    string currentLexeme;
+    size_t tokenStart = 0;
     LexerState state = LexerState::START;
     int tokenStartColumn;
+    LexerEngine engine;
+    shared_ptr<SymbolTable> symbolTable = make_shared<SymbolTable>();
+
+    TokenTypes getKeywordType(string_view lexeme) const {
+        return findKeyword(lexeme);
+    }
+
+    // текущая лексема - это срез исходного текста [tokenStart, curPos)
+    string_view currentLexeme() const {
+        return sourceCode.substr(tokenStart, curPos - tokenStart);
+    }
+
+    TokenView createToken(TokenTypes type, string_view value) const {
+        TokenView token(type, value, curLine, tokenStartColumn);
+        if (type == TokenTypes::IDENTIFIER) {
+            token.hash = SymbolTable::hashOf(value);
+            token.symbol = symbolTable->intern(value, token.hash);
+        }
+        else if (isNumericLiteral(type)) {
+            token.number = parseNumericLiteral(value);
+            if (token.number == HUGE_VAL) {
+                throw runtime_error("Error: Numeric literal is out of range '" + string(value) + "' at line " + to_string(curLine) + ", column " + to_string(tokenStartColumn));
+            }
+        }
+        return token;
+    }
 
-    vector<string> keywords = { "program", "const", "var", "begin", "end", "if", "then", "else", "mod", "div", "integer", "double", "string", "Write", "Read" };
-
-    TokenTypes getKeywordType(const string& lexeme) {
-        if (lexeme == "program") return TokenTypes::KEYWORD_PROGRAM;
-        if (lexeme == "const") return TokenTypes::KEYWORD_CONST;
-        if (lexeme == "var") return TokenTypes::KEYWORD_VAR;
-        if (lexeme == "begin") return TokenTypes::KEYWORD_BEGIN;
-        if (lexeme == "end") return TokenTypes::KEYWORD_END;
-        if (lexeme == "if") return TokenTypes::KEYWORD_IF;
-        if (lexeme == "then") return TokenTypes::KEYWORD_THEN;
-        if (lexeme == "else") return TokenTypes::KEYWORD_ELSE;
-        if (lexeme == "mod") return TokenTypes::KEYWORD_MOD;
-        if (lexeme == "div") return TokenTypes::KEYWORD_DIV;
-        if (lexeme == "integer") return TokenTypes::KEYWORD_INTEGER;
-        if (lexeme == "double") return TokenTypes::KEYWORD_DOUBLE;
-        if (lexeme == "string") return TokenTypes::KEYWORD_STRING;
-        if (lexeme == "Write") return TokenTypes::KEYWORD_WRITE;
-        if (lexeme == "Read") return TokenTypes::KEYWORD_READ;
-        return TokenTypes::UNKNOWN;
+    TokenView createToken(TokenTypes type) const {
+        return createToken(type, currentLexeme());
     }
 
-    Token createToken(TokenTypes type, const string& value) const {
-        return Token(type, value, curLine, tokenStartColumn);
+    // сдвиг внутри одной строки исходного текста
+    void advanceTo(size_t position) {
+        curColumn += int(position - curPos);
+        curPos = position;
     }
 
-    optional<Token> nextToken() {
+    optional<TokenView> nextToken() {
+        return engine == LexerEngine::TABLE ? nextTableToken() : nextSwitchToken();
+    }
+
+    optional<TokenView> nextTableToken() {
+        const char* data = sourceCode.data();
+        size_t size = sourceCode.size();
+
+        if (curPos < size && lexerTables.charClass[static_cast<unsigned char>(data[curPos])] == CLASS_SPACE) {
+            int newlines;
+            size_t lastNewline = 0;
+            size_t spacesEnd = CharScanner::skipSpaces(data, curPos, size, newlines, lastNewline);
+            if (newlines > 0) {
+                curLine += newlines;
+                curColumn = int(spacesEnd - lastNewline - 1);
+            }
+            else {
+                curColumn += int(spacesEnd - curPos);
+            }
+            curPos = spacesEnd;
+        }
+        if (curPos >= size) {
+            return nullopt;
+        }
+
+        tokenStart = curPos;
+        tokenStartColumn = curColumn + 1;
+
+        // самая длинная лексема: идём по переходам, пока автомат не остановится
+        uint8_t current = DFA_START;
+        size_t pos = curPos;
+        while (pos < size) {
+            uint8_t next = lexerTables.next[current][lexerTables.charClass[static_cast<unsigned char>(data[pos])]];
+            if (next == DFA_STOP) {
+                break;
+            }
+            current = next;
+            pos++;
+        }
+        advanceTo(pos);
+
+        switch (current) {
+        case DFA_START:
+            advanceTo(pos + 1);
+            throw runtime_error("Error: Unknown token '" + string(currentLexeme()) + "' at line " + to_string(curLine) + ", column " + to_string(tokenStartColumn));
+
+        case DFA_STRING: {
+            tokenStart = curPos;
+            size_t closingQuote = sourceCode.find('"', curPos);
+            if (closingQuote == string_view::npos) {
+                throw runtime_error("Error: Unterminated string literal at line " + to_string(curLine) + ", column " + to_string(tokenStartColumn));
+            }
+            advanceTo(closingQuote + 1);
+            return createToken(TokenTypes::STRING_LITERAL, sourceCode.substr(tokenStart, closingQuote - tokenStart));
+        }
+
+        case DFA_IDENTIFIER: {
+            if (curPos < size && data[curPos] == '.' && currentLexeme() == "end") {
+                advanceTo(curPos + 1);
+                return createToken(TokenTypes::END_OF_PROGRAM);
+            }
+            TokenTypes type = getKeywordType(currentLexeme());
+            return createToken(type == TokenTypes::UNKNOWN ? TokenTypes::IDENTIFIER : type);
+        }
+
+        default:
+            return createToken(lexerTables.accept[current]);
+        }
+    }
+
+    optional<TokenView> nextSwitchToken() {
         while (curPos < sourceCode.length()) {
             char currentChar = sourceCode[curPos];
 
             switch (state) {
             case LexerState::START:
-                currentLexeme.clear();
+                tokenStart = curPos;
                 tokenStartColumn = curColumn + 1;
 
                 if (isspace(currentChar)) {
-                    if (currentChar == '\n') {
-                        curLine++;
-                        curColumn = 0;
+                    int newlines;
+                    size_t lastNewline = 0;
+                    size_t spacesEnd = CharScanner::skipSpaces(sourceCode.data(), curPos, sourceCode.size(), newlines, lastNewline);
+                    if (newlines > 0) {
+                        curLine += newlines;
+                        curColumn = int(spacesEnd - lastNewline - 1);
                     }
                     else {
-                        curColumn++;
+                        curColumn += int(spacesEnd - curPos);
                     }
-                    curPos++;
+                    curPos = spacesEnd;
                 }
                 else if (isalpha(currentChar) || currentChar == '_') {
                     state = LexerState::IDENTIFIER;
-                    currentLexeme += currentChar;
                     curPos++;
                     curColumn++;
                 }
                 else if (isdigit(currentChar)) {
                     state = LexerState::INTEGER;
-                    currentLexeme += currentChar;
                     curPos++;
                     curColumn++;
                 }
@@ -93,202 +195,416 @@ private:
                     state = LexerState::STRING;
                     curPos++;
                     curColumn++;
+                    tokenStart = curPos; // кавычки в лексему не входят
                 }
                 else if (currentChar == ':') {
                     state = LexerState::ASSIGN;
-                    currentLexeme += currentChar;
                     curPos++;
                     curColumn++;
                 }
                 else if (currentChar == '>') {
                     state = LexerState::GREATER_THAN;
-                    currentLexeme += currentChar;
                     curPos++;
                     curColumn++;
                 }
                 else if (currentChar == '<') {
                     state = LexerState::LESS_THAN;
-                    currentLexeme += currentChar;
                     curPos++;
                     curColumn++;
                 }
                 else {
-                    currentLexeme += currentChar;
                     curPos++;
                     curColumn++;
                     switch (currentChar) {
-                    case '+': return createToken(TokenTypes::PLUS, currentLexeme);
-                    case '-': return createToken(TokenTypes::MINUS, currentLexeme);
-                    case '*': return createToken(TokenTypes::MULTIPLY, currentLexeme);
-                    case '/': return createToken(TokenTypes::DIVIDE, currentLexeme);
-                    case '=': return createToken(TokenTypes::EQUAL, currentLexeme);
-                    case ';': return createToken(TokenTypes::SEMICOLON, currentLexeme);
-                    case ',': return createToken(TokenTypes::COMMA, currentLexeme);
-                    case '(': return createToken(TokenTypes::LEFT_PAREN, currentLexeme);
-                    case ')': return createToken(TokenTypes::RIGHT_PAREN, currentLexeme);
-                    case '.': return createToken(TokenTypes::UNKNOWN, currentLexeme); //    
+                    case '+': return createToken(TokenTypes::PLUS);
+                    case '-': return createToken(TokenTypes::MINUS);
+                    case '*': return createToken(TokenTypes::MULTIPLY);
+                    case '/': return createToken(TokenTypes::DIVIDE);
+                    case '=': return createToken(TokenTypes::EQUAL);
+                    case ';': return createToken(TokenTypes::SEMICOLON);
+                    case ',': return createToken(TokenTypes::COMMA);
+                    case '(': return createToken(TokenTypes::LEFT_PAREN);
+                    case ')': return createToken(TokenTypes::RIGHT_PAREN);
+                    case '.': return createToken(TokenTypes::UNKNOWN); // Точка сама по себе
                     default:
-                        throw runtime_error("Error: Unknown token '" + currentLexeme + "' at line " + to_string(curLine) + ", column " + to_string(tokenStartColumn));
+                        throw runtime_error("Error: Unknown token '" + string(currentLexeme()) + "' at line " + to_string(curLine) + ", column " + to_string(tokenStartColumn));
                     }
                 }
                 break;
 
             case LexerState::IDENTIFIER:
                 if (isalnum(currentChar) || currentChar == '_') {
-                    currentLexeme += currentChar;
-                    curPos++;
-                    curColumn++;
+                    advanceTo(CharScanner::skipIdentifier(sourceCode.data(), curPos, sourceCode.size()));
                 }
                 else {
                     state = LexerState::START;
-                    if (currentLexeme == "end" && curPos < sourceCode.length() && sourceCode[curPos] == '.') {
-                        currentLexeme += sourceCode[curPos];
+                    if (currentLexeme() == "end" && currentChar == '.') {
                         curPos++;
                         curColumn++;
-                        return createToken(TokenTypes::END_OF_PROGRAM, currentLexeme);
+                        return createToken(TokenTypes::END_OF_PROGRAM);
                     }
                     else {
-                        TokenTypes type = getKeywordType(currentLexeme);
+                        TokenTypes type = getKeywordType(currentLexeme());
                         if (type == TokenTypes::UNKNOWN) {
                             type = TokenTypes::IDENTIFIER;
                         }
-                        return createToken(type, currentLexeme);
+                        return createToken(type);
                     }
                 }
                 break;
 
             case LexerState::INTEGER:
                 if (isdigit(currentChar)) {
-                    currentLexeme += currentChar;
-                    curPos++;
-                    curColumn++;
+                    advanceTo(CharScanner::skipDigits(sourceCode.data(), curPos, sourceCode.size()));
                 }
                 else if (currentChar == '.') {
                     state = LexerState::DOUBLE;
-                    currentLexeme += currentChar;
                     curPos++;
                     curColumn++;
                 }
                 else {
                     state = LexerState::START;
-                    return createToken(TokenTypes::INTEGER_LITERAL, currentLexeme);
+                    return createToken(TokenTypes::INTEGER_LITERAL);
                 }
                 break;
 
             case LexerState::DOUBLE:
                 if (isdigit(currentChar)) {
-                    currentLexeme += currentChar;
-                    curPos++;
-                    curColumn++;
+                    advanceTo(CharScanner::skipDigits(sourceCode.data(), curPos, sourceCode.size()));
                 }
                 else {
                     state = LexerState::START;
-                    return createToken(TokenTypes::DOUBLE_LITERAL, currentLexeme);
+                    return createToken(TokenTypes::DOUBLE_LITERAL);
                 }
                 break;
 
-            case LexerState::STRING:
-                curPos++;
-                curColumn++;
-                if (currentChar == '"') {
-                    state = LexerState::START;
-                    return createToken(TokenTypes::STRING_LITERAL, currentLexeme);
-                }
-                currentLexeme += currentChar;
-                if (curPos >= sourceCode.length()) {
+            case LexerState::STRING: {
+                // переводы строк внутри строки номер строки не меняют
+                size_t closingQuote = sourceCode.find('"', curPos);
+                if (closingQuote == string_view::npos) {
                     throw runtime_error("Error: Unterminated string literal at line " + to_string(curLine) + ", column " + to_string(tokenStartColumn));
                 }
-                break;
+                advanceTo(closingQuote + 1);
+                state = LexerState::START;
+                return createToken(TokenTypes::STRING_LITERAL, sourceCode.substr(tokenStart, closingQuote - tokenStart));
+            }
 
             case LexerState::ASSIGN:
-                currentLexeme += currentChar;
-                curPos++;
-                curColumn++;
                 state = LexerState::START;
                 if (currentChar == '=') {
-                    return createToken(TokenTypes::ASSIGN, currentLexeme);
+                    curPos++;
+                    curColumn++;
+                    return createToken(TokenTypes::ASSIGN);
                 }
                 else {
-                    return createToken(TokenTypes::COLON, currentLexeme.substr(0, 1)); //   ':'
+                    return createToken(TokenTypes::COLON); // ':' без '=', следующий символ не трогаем
                 }
 
             case LexerState::GREATER_THAN:
-                if (curPos < sourceCode.length() && sourceCode[curPos] == '=') {
-                    currentLexeme += sourceCode[curPos];
+                state = LexerState::START;
+                if (currentChar == '=') {
                     curPos++;
                     curColumn++;
-                    state = LexerState::START;
-                    return createToken(TokenTypes::GREATER_OR_EQUAL, currentLexeme);
+                    return createToken(TokenTypes::GREATER_OR_EQUAL);
                 }
-                else {
-                    state = LexerState::START;
-                    return createToken(TokenTypes::GREATER, currentLexeme);
-                }
-                break;
+                return createToken(TokenTypes::GREATER);
 
             case LexerState::LESS_THAN:
-                if (curPos < sourceCode.length() && sourceCode[curPos] == '=') {
-                    currentLexeme += sourceCode[curPos];
+                state = LexerState::START;
+                if (currentChar == '=') {
                     curPos++;
                     curColumn++;
-                    state = LexerState::START;
-                    return createToken(TokenTypes::LESS_OR_EQUAL, currentLexeme);
+                    return createToken(TokenTypes::LESS_OR_EQUAL);
                 }
-                else if (curPos < sourceCode.length() && sourceCode[curPos] == '>') {
-                    currentLexeme += sourceCode[curPos];
+                else if (currentChar == '>') {
                     curPos++;
                     curColumn++;
-                    state = LexerState::START;
-                    return createToken(TokenTypes::NON_EQUAL, currentLexeme);
+                    return createToken(TokenTypes::NON_EQUAL);
                 }
-                else {
-                    state = LexerState::START;
-                    return createToken(TokenTypes::LESS, currentLexeme);
-                }
-                break;
+                return createToken(TokenTypes::LESS);
             }
         }
 
-        if (!currentLexeme.empty()) {
-            switch (state) {
+        LexerState lastState = state;
+        state = LexerState::START;
+        if (curPos > tokenStart || lastState == LexerState::STRING) {
+            switch (lastState) {
             case LexerState::IDENTIFIER: {
-                TokenTypes type = getKeywordType(currentLexeme);
+                TokenTypes type = getKeywordType(currentLexeme());
                 if (type == TokenTypes::UNKNOWN) {
                     type = TokenTypes::IDENTIFIER;
                 }
-                state = LexerState::START;
-                return createToken(type, currentLexeme);
+                return createToken(type);
             }
             case LexerState::INTEGER:
-                state = LexerState::START;
-                return createToken(TokenTypes::INTEGER_LITERAL, currentLexeme);
+                return createToken(TokenTypes::INTEGER_LITERAL);
             case LexerState::DOUBLE:
-                state = LexerState::START;
-                return createToken(TokenTypes::DOUBLE_LITERAL, currentLexeme);
+                return createToken(TokenTypes::DOUBLE_LITERAL);
             case LexerState::STRING:
                 throw runtime_error("Error: Unterminated string literal at line " + to_string(curLine) + ", column " + to_string(tokenStartColumn));
             case LexerState::ASSIGN:
-                state = LexerState::START;
-                return createToken(TokenTypes::COLON, currentLexeme.substr(0, 1)); //  ':'  '='
+                return createToken(TokenTypes::COLON); // обработка ':' без '='
+            case LexerState::GREATER_THAN:
+                return createToken(TokenTypes::GREATER);
+            case LexerState::LESS_THAN:
+                return createToken(TokenTypes::LESS);
             default:
-                //   START    
+                // в состоянии START ничего не должно оставаться
                 break;
             }
         }
-        return nullopt; //   
+        return nullopt; // Достигнут конец файла
+    }
+
+    void reset() {
+        curPos = 0;
+        curLine = 1;
+        curColumn = 0;
+        tokenStart = 0;
+        state = LexerState::START;
+    }
+
+    // лексер для части текста [begin, end), которая начинается с начала строки
+    Lexer(shared_ptr<const SourceBuffer> source, size_t begin, size_t end, LexerEngine lexerEngine)
+        : buffer(move(source)), curPos(0), curLine(1), curColumn(0), engine(lexerEngine) {
+        sourceCode = buffer->text().substr(begin, end - begin);
+    }
+
+    // Границы частей для параллельного разбора: сразу после '\n', который лежит
+    // вне строкового литерала (перед ним чётное число кавычек).
+    // Лексемы, кроме строк, через перевод строки не переходят.
+    vector<size_t> findChunkBoundaries(size_t chunksCount) const {
+        const size_t size = sourceCode.size();
+        size_t chunkSize = max(size / chunksCount, parallelMinChunk);
+        vector<size_t> boundaries = { 0 };
+        size_t scanned = 0;
+        bool insideString = false;
+        while (boundaries.back() + chunkSize < size) {
+            size_t pos = boundaries.back() + chunkSize;
+            size_t newline;
+            while ((newline = sourceCode.find('\n', pos)) != string_view::npos) {
+                insideString ^= count(sourceCode.begin() + scanned, sourceCode.begin() + newline, '"') % 2 != 0;
+                scanned = newline;
+                if (!insideString) {
+                    break;
+                }
+                pos = newline + 1;
+            }
+            if (newline == string_view::npos) {
+                break;
+            }
+            boundaries.push_back(newline + 1);
+        }
+        boundaries.push_back(size);
+        return boundaries;
+    }
+
+    // задачи 0..tasks-1 разбираются потоками по очереди через общий счётчик
+    template <typename Func>
+    static void runOnThreads(size_t tasks, unsigned threadsCount, Func func) {
+        atomic<size_t> nextTask(0);
+        auto worker = [&]() {
+            size_t task;
+            while ((task = nextTask++) < tasks) {
+                func(task);
+            }
+        };
+        vector<thread> pool;
+        for (unsigned i = 1; i < threadsCount && i < tasks; i++) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (thread& t : pool) {
+            t.join();
+        }
     }
 
 public:
-    Lexer(const string& source) : sourceCode(source), curPos(0), curLine(1), curColumn(0) {}
+    // меньше этого размера текст на части не делится
+    static constexpr size_t parallelMinChunk = 1 << 16;
+
+    Lexer(const string& source, LexerEngine lexerEngine = LexerEngine::SWITCH) : Lexer(SourceBuffer::fromString(source), lexerEngine) {}
+
+    Lexer(shared_ptr<const SourceBuffer> source, LexerEngine lexerEngine = LexerEngine::SWITCH)
+        : buffer(move(source)), sourceCode(buffer->text()), curPos(0), curLine(1), curColumn(0), engine(lexerEngine) {}
+
+    // Текст берётся прямо из отображённого в память файла, без копии в string
+    static Lexer fromFile(const string& path, LexerEngine lexerEngine = LexerEngine::SWITCH) {
+        return Lexer(SourceBuffer::fromFile(path), lexerEngine);
+    }
+
+    // движок можно сменить между проходами; разбор начинается заново
+    void setEngine(LexerEngine lexerEngine) {
+        engine = lexerEngine;
+        reset();
+    }
+
+    LexerEngine getEngine() const {
+        return engine;
+    }
+
+    // таблица имён, в которую попадают идентификаторы
+    shared_ptr<SymbolTable> symbols() const {
+        return symbolTable;
+    }
+
+    // общая таблица для нескольких лексеров: номера имён совпадают
+    void shareSymbols(shared_ptr<SymbolTable> table) {
+        symbolTable = move(table);
+    }
+
+    // буфер, в который указывают лексемы из tokenizeViews()
+    shared_ptr<const SourceBuffer> source() const {
+        return buffer;
+    }
+
+    // Потоковый режим: лексемы выдаются по одной, без общего вектора
+    optional<Token> next() {
+        optional<TokenView> view = nextToken();
+        if (!view.has_value()) {
+            return nullopt;
+        }
+        return view->toToken();
+    }
+
+    optional<TokenView> nextView() {
+        return nextToken();
+    }
+
+    class iterator {
+    private:
+        Lexer* lexer = nullptr;
+        optional<TokenView> current;
+
+    public:
+        using iterator_category = input_iterator_tag;
+        using value_type = TokenView;
+        using difference_type = ptrdiff_t;
+        using pointer = const TokenView*;
+        using reference = const TokenView&;
+
+        iterator() = default;
+        explicit iterator(Lexer* lx) : lexer(lx), current(lx->nextToken()) {}
+
+        const TokenView& operator*() const { return *current; }
+        const TokenView* operator->() const { return &*current; }
+
+        iterator& operator++() {
+            current = lexer->nextToken();
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const { return current.has_value() == other.current.has_value(); }
+        bool operator!=(const iterator& other) const { return !(*this == other); }
+    };
+
+    // for (const TokenView& token : lexer) - разбор с начала текста по требованию
+    iterator begin() {
+        reset();
+        return iterator(this);
+    }
+
+    iterator end() {
+        return iterator();
+    }
 
     vector<Token> tokenize() {
         vector<Token> tokens;
-        optional<Token> token;
-        curPos = 0;
-        curLine = 1;
-        curColumn = 0;
+        optional<TokenView> token;
+        reset();
+        while ((token = nextToken()).has_value()) {
+            tokens.push_back(token->toToken());
+        }
+        return tokens;
+    }
+
+    // Параллельный разбор большого текста: результат совпадает с tokenize().
+    // threadsCount = 0 - по числу ядер. При ошибке в любой части текст
+    // разбирается заново последовательно, чтобы сообщение было тем же.
+    vector<Token> tokenizeParallel(unsigned threadsCount = 0) {
+        if (threadsCount == 0) {
+            threadsCount = max(1u, thread::hardware_concurrency());
+        }
+        if (threadsCount == 1 || sourceCode.size() < 2 * parallelMinChunk) {
+            return tokenize();
+        }
+
+        // частей больше, чем потоков, чтобы потоки не простаивали
+        vector<size_t> boundaries = findChunkBoundaries(size_t(threadsCount) * 4);
+        size_t chunksCount = boundaries.size() - 1;
+        vector<vector<Token>> chunkTokens(chunksCount);
+        vector<int> chunkLines(chunksCount);
+        vector<shared_ptr<SymbolTable>> chunkSymbols(chunksCount);
+        atomic<bool> failed(false);
+
+        runOnThreads(chunksCount, threadsCount, [&](size_t chunk) {
+            try {
+                Lexer chunkLexer(buffer, boundaries[chunk], boundaries[chunk + 1], engine);
+                optional<TokenView> token;
+                while ((token = chunkLexer.nextToken()).has_value()) {
+                    chunkTokens[chunk].push_back(token->toToken());
+                }
+                chunkLines[chunk] = chunkLexer.curLine - 1;
+                chunkSymbols[chunk] = chunkLexer.symbolTable;
+            }
+            catch (const exception&) {
+                failed = true;
+            }
+        });
+        if (failed) {
+            return tokenize();
+        }
+
+        // сдвиги частей в общем векторе и номера их первых строк;
+        // имена частей переносятся в общую таблицу по порядку частей,
+        // поэтому номера получаются те же, что при последовательном разборе
+        vector<size_t> tokenOffsets(chunksCount + 1, 0);
+        vector<int> lineOffsets(chunksCount, 0);
+        vector<vector<uint32_t>> symbolRemap(chunksCount);
+        for (size_t chunk = 0; chunk < chunksCount; chunk++) {
+            const SymbolTable& local = *chunkSymbols[chunk];
+            for (uint32_t id = 0; id < local.size(); id++) {
+                symbolRemap[chunk].push_back(symbolTable->intern(local.name(id), local.hash(id)));
+            }
+            tokenOffsets[chunk + 1] = tokenOffsets[chunk] + chunkTokens[chunk].size();
+            if (chunk + 1 < chunksCount) {
+                lineOffsets[chunk + 1] = lineOffsets[chunk] + chunkLines[chunk];
+            }
+        }
+
+        vector<Token> tokens(tokenOffsets[chunksCount]);
+        runOnThreads(chunksCount, threadsCount, [&](size_t chunk) {
+            Token* out = tokens.data() + tokenOffsets[chunk];
+            for (Token& token : chunkTokens[chunk]) {
+                token.line += lineOffsets[chunk];
+                if (token.symbol != NO_SYMBOL) {
+                    token.symbol = symbolRemap[chunk][token.symbol];
+                }
+                *out++ = move(token);
+            }
+            vector<Token>().swap(chunkTokens[chunk]);
+        });
+        return tokens;
+    }
+
+    // Компактный разбор для парсера: 9 байт на лексему вместо Token
+    TokenBuffer tokenizeBuffer() {
+        TokenBuffer tokens(buffer, symbolTable);
+        optional<TokenView> token;
+        reset();
+        while ((token = nextToken()).has_value()) {
+            tokens.push(*token);
+        }
+        return tokens;
+    }
+
+    // Разбор без копирования текста лексем: в куче выделяется только сам вектор
+    vector<TokenView> tokenizeViews() {
+        vector<TokenView> tokens;
+        optional<TokenView> token;
+        reset();
         while ((token = nextToken()).has_value()) {
-            tokens.push_back(token.value());
+            tokens.push_back(*token);
         }
         return tokens;
     }
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include "../Base/Token.h"
+
+using namespace std;
+
+// Таблицы для табличного движка лексера (LexerEngine::TABLE).
+// Классы символов и переходы автомата строятся при компиляции
+// из списка знаков пунктуации и правил для имён, чисел и строк.
+
+struct Punctuator {
+    string_view text;
+    TokenTypes type;
+};
+
+constexpr Punctuator punctuatorList[] = {
+    { "+", TokenTypes::PLUS },
+    { "-", TokenTypes::MINUS },
+    { "*", TokenTypes::MULTIPLY },
+    { "/", TokenTypes::DIVIDE },
+    { "=", TokenTypes::EQUAL },
+    { ";", TokenTypes::SEMICOLON },
+    { ",", TokenTypes::COMMA },
+    { "(", TokenTypes::LEFT_PAREN },
+    { ")", TokenTypes::RIGHT_PAREN },
+    { ":", TokenTypes::COLON },
+    { ":=", TokenTypes::ASSIGN },
+    { "<", TokenTypes::LESS },
+    { "<=", TokenTypes::LESS_OR_EQUAL },
+    { "<>", TokenTypes::NON_EQUAL },
+    { ">", TokenTypes::GREATER },
+    { ">=", TokenTypes::GREATER_OR_EQUAL },
+    { ".", TokenTypes::UNKNOWN } // точка сама по себе
+};
+
+// классы символов; знакам пунктуации номера выдаются начиная с CLASS_FIRST_PUNCTUATOR
+constexpr uint8_t CLASS_OTHER = 0;
+constexpr uint8_t CLASS_SPACE = 1;
+constexpr uint8_t CLASS_LETTER = 2;
+constexpr uint8_t CLASS_DIGIT = 3;
+constexpr uint8_t CLASS_QUOTE = 4;
+constexpr uint8_t CLASS_FIRST_PUNCTUATOR = 5;
+
+// состояния автомата; состояния знаков пунктуации идут после DFA_FIRST_PUNCTUATOR
+constexpr uint8_t DFA_STOP = 0;
+constexpr uint8_t DFA_START = 1;
+constexpr uint8_t DFA_IDENTIFIER = 2;
+constexpr uint8_t DFA_INTEGER = 3;
+constexpr uint8_t DFA_DOUBLE = 4;
+constexpr uint8_t DFA_STRING = 5; // открывающая кавычка, дальше строку дочитывает лексер
+constexpr uint8_t DFA_FIRST_PUNCTUATOR = 6;
+
+constexpr size_t dfaMaxClasses = 32;
+constexpr size_t dfaMaxStates = 32;
+
+struct LexerTables {
+    array<uint8_t, 256> charClass{};
+    array<array<uint8_t, dfaMaxClasses>, dfaMaxStates> next{};
+    array<TokenTypes, dfaMaxStates> accept{};
+    size_t classCount = CLASS_FIRST_PUNCTUATOR;
+    size_t stateCount = DFA_FIRST_PUNCTUATOR;
+};
+
+constexpr bool isLexerSpace(unsigned char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+constexpr bool isLexerLetter(unsigned char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
+constexpr bool isLexerDigit(unsigned char c) { return c >= '0' && c <= '9'; }
+
+constexpr LexerTables buildLexerTables() {
+    LexerTables tables{};
+
+    for (size_t c = 0; c < 256; c++) {
+        unsigned char ch = static_cast<unsigned char>(c);
+        tables.charClass[c] = isLexerSpace(ch) ? CLASS_SPACE
+            : isLexerLetter(ch) ? CLASS_LETTER
+            : isLexerDigit(ch) ? CLASS_DIGIT
+            : ch == '"' ? CLASS_QUOTE
+            : CLASS_OTHER;
+    }
+    for (const Punctuator& punctuator : punctuatorList) {
+        for (char ch : punctuator.text) {
+            uint8_t& cls = tables.charClass[static_cast<unsigned char>(ch)];
+            if (cls == CLASS_OTHER) {
+                cls = static_cast<uint8_t>(tables.classCount++);
+            }
+        }
+    }
+
+    tables.next[DFA_START][CLASS_LETTER] = DFA_IDENTIFIER;
+    tables.next[DFA_START][CLASS_DIGIT] = DFA_INTEGER;
+    tables.next[DFA_START][CLASS_QUOTE] = DFA_STRING;
+    tables.next[DFA_IDENTIFIER][CLASS_LETTER] = DFA_IDENTIFIER;
+    tables.next[DFA_IDENTIFIER][CLASS_DIGIT] = DFA_IDENTIFIER;
+    tables.next[DFA_INTEGER][CLASS_DIGIT] = DFA_INTEGER;
+    tables.next[DFA_INTEGER][tables.charClass['.']] = DFA_DOUBLE;
+    tables.next[DFA_DOUBLE][CLASS_DIGIT] = DFA_DOUBLE;
+
+    tables.accept[DFA_IDENTIFIER] = TokenTypes::IDENTIFIER;
+    tables.accept[DFA_INTEGER] = TokenTypes::INTEGER_LITERAL;
+    tables.accept[DFA_DOUBLE] = TokenTypes::DOUBLE_LITERAL;
+    tables.accept[DFA_STRING] = TokenTypes::STRING_LITERAL;
+
+    // префиксное дерево знаков пунктуации: ":" -> ":=", "<" -> "<=", "<>" ...
+    for (const Punctuator& punctuator : punctuatorList) {
+        uint8_t state = DFA_START;
+        for (char ch : punctuator.text) {
+            uint8_t cls = tables.charClass[static_cast<unsigned char>(ch)];
+            if (tables.next[state][cls] == DFA_STOP) {
+                tables.next[state][cls] = static_cast<uint8_t>(tables.stateCount++);
+            }
+            state = tables.next[state][cls];
+        }
+        tables.accept[state] = punctuator.type;
+    }
+    return tables;
+}
+
+constexpr LexerTables lexerTables = buildLexerTables();
+
+static_assert(lexerTables.classCount <= dfaMaxClasses, "too many character classes, increase dfaMaxClasses");
+static_assert(lexerTables.stateCount <= dfaMaxStates, "too many DFA states, increase dfaMaxStates");
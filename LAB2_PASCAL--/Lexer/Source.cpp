@@ -1,14 +1,155 @@
 #include "Lexer.h"
+#include "IncrementalLexer.h"
+#include "AllocationCounter.h"
 #include <iostream>
 #include <string>
 #include <regex>
 #include <vector>
 #include <variant>
+#include <chrono>
 
 using namespace std;
 
+// программа, похожая на сгенерированную: длинные имена, много присваиваний
+string generateProgram(int statements, int indent = 4) {
+    string padding(indent, ' ');
+    const int variablesCount = 64;
+    string code = "program Generated;\nvar\n";
+    for (int i = 0; i < variablesCount; i++)
+        code += "    generated_variable_" + to_string(i) + (i + 1 < variablesCount ? ",\n" : " : integer;\n");
+    code += "begin\n";
+    for (int i = 0; i < statements; i++) {
+        string target = "generated_variable_" + to_string(i % variablesCount);
+        string source = "generated_variable_" + to_string((i * 7 + 3) % variablesCount);
+        code += padding + target + " := (" + source + " + " + to_string(i) + ") * 2 div 3;\n";
+        if (i % 8 == 0)
+            code += padding + "Write(\"generated value = \", " + target + ");\n";
+    }
+    code += "end.";
+    return code;
+}
+
+template <typename Func>
+void measure(const string& name, size_t bytes, Func func) {
+    size_t allocationsBefore = allocationCount();
+    auto start = chrono::high_resolution_clock::now();
+    size_t tokensCount = func();
+    auto end = chrono::high_resolution_clock::now();
+    chrono::duration<double> time = end - start;
+    double allocationsPerToken = double(allocationCount() - allocationsBefore) / double(tokensCount);
+    cout << name << ": " << tokensCount << " tokens, " << time.count() << " s, "
+        << bytes / time.count() / 1e6 << " MB/s, " << allocationsPerToken << " allocations per token\n";
+}
+
+// прежняя цепочка сравнений - для сравнения с findKeyword
+TokenTypes legacyKeywordType(const string& lexeme) {
+    if (lexeme == "program") return TokenTypes::KEYWORD_PROGRAM;
+    if (lexeme == "const") return TokenTypes::KEYWORD_CONST;
+    if (lexeme == "var") return TokenTypes::KEYWORD_VAR;
+    if (lexeme == "begin") return TokenTypes::KEYWORD_BEGIN;
+    if (lexeme == "end") return TokenTypes::KEYWORD_END;
+    if (lexeme == "if") return TokenTypes::KEYWORD_IF;
+    if (lexeme == "then") return TokenTypes::KEYWORD_THEN;
+    if (lexeme == "else") return TokenTypes::KEYWORD_ELSE;
+    if (lexeme == "mod") return TokenTypes::KEYWORD_MOD;
+    if (lexeme == "div") return TokenTypes::KEYWORD_DIV;
+    if (lexeme == "integer") return TokenTypes::KEYWORD_INTEGER;
+    if (lexeme == "double") return TokenTypes::KEYWORD_DOUBLE;
+    if (lexeme == "string") return TokenTypes::KEYWORD_STRING;
+    if (lexeme == "Write") return TokenTypes::KEYWORD_WRITE;
+    if (lexeme == "Read") return TokenTypes::KEYWORD_READ;
+    return TokenTypes::UNKNOWN;
+}
+
+void benchmarkKeywords() {
+    vector<string> lexemes = { "counter", "i", "x1", "total_sum", "begin", "result", "tmp", "index",
+        "value", "end", "delta", "Write", "accumulator", "y", "if", "temp_value" };
+    const int rounds = 2000000;
+    size_t checksum = 0;
+
+    auto start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < rounds; i++)
+        for (const string& lexeme : lexemes)
+            checksum += static_cast<size_t>(legacyKeywordType(lexeme));
+    auto middle = chrono::high_resolution_clock::now();
+    for (int i = 0; i < rounds; i++)
+        for (const string& lexeme : lexemes)
+            checksum += static_cast<size_t>(findKeyword(lexeme));
+    auto end = chrono::high_resolution_clock::now();
+
+    chrono::duration<double> legacyTime = middle - start;
+    chrono::duration<double> hashTime = end - middle;
+    double lookups = double(rounds) * lexemes.size();
+    cout << "keywords: comparison chain " << legacyTime.count() / lookups * 1e9 << " ns/lookup, perfect hash "
+        << hashTime.count() / lookups * 1e9 << " ns/lookup (checksum " << checksum << ")\n";
+}
+
+// правка по одному символу: полный разбор против IncrementalLexer
+void benchmarkIncremental() {
+    for (int statements : { 2000, 20000, 200000 }) {
+        string code = generateProgram(statements);
+        IncrementalLexer incremental(code);
+        const int fullEdits = 20, edits = 200;
+
+        auto start = chrono::high_resolution_clock::now();
+        size_t checksum = 0;
+        for (int i = 0; i < fullEdits; i++) {
+            code.insert(code.size() / 2, "1");
+            checksum += Lexer(code).tokenize().size();
+        }
+        auto middle = chrono::high_resolution_clock::now();
+        for (int i = 0; i < edits; i++) {
+            checksum += incremental.apply({ incremental.source().size() / 2, 0, "1" }).inserted;
+        }
+        auto end = chrono::high_resolution_clock::now();
+
+        chrono::duration<double> fullTime = middle - start;
+        chrono::duration<double> incrementalTime = end - middle;
+        cout << "edit in " << code.size() / 1024 << " KB: full tokenize " << fullTime.count() / fullEdits * 1e6
+            << " us/edit, incremental " << incrementalTime.count() / edits * 1e6 << " us/edit (checksum " << checksum << ")\n";
+    }
+}
+
+void runBenchmarks() {
+    benchmarkKeywords();
+
+    string code = generateProgram(200000);
+    Lexer lexer(code);
+    measure("tokenize", code.size(), [&]() { return lexer.tokenize().size(); });
+    measure("tokenizeViews", code.size(), [&]() { return lexer.tokenizeViews().size(); });
+
+    string indented = generateProgram(200000, 32);
+    Lexer indentedLexer(indented);
+    measure("tokenizeViews, 32-space indentation", indented.size(), [&]() { return indentedLexer.tokenizeViews().size(); });
+
+    // switch-автомат против табличного на одном и том же тексте
+    for (LexerEngine engine : { LexerEngine::SWITCH, LexerEngine::TABLE }) {
+        string name = engine == LexerEngine::SWITCH ? "switch engine" : "table engine";
+        lexer.setEngine(engine);
+        indentedLexer.setEngine(engine);
+        lexer.tokenizeViews(); // прогрев
+        measure(name + ", tokenizeViews", code.size(), [&]() { return lexer.tokenizeViews().size(); });
+        measure(name + ", tokenizeViews, 32-space indentation", indented.size(), [&]() { return indentedLexer.tokenizeViews().size(); });
+    }
+
+    // параллельный разбор нескольких десятков мегабайт
+    string large = generateProgram(1500000);
+    Lexer largeLexer(large);
+    measure("tokenize, large program", large.size(), [&]() { return largeLexer.tokenize().size(); });
+    for (unsigned threads : { 1u, 2u, 4u, 8u }) {
+        measure("tokenizeParallel, " + to_string(threads) + " threads", large.size(), [&]() { return largeLexer.tokenizeParallel(threads).size(); });
+    }
+    cout << "hardware threads: " << thread::hardware_concurrency() << '\n';
+
+    benchmarkIncremental();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        runBenchmarks();
+        return 0;
+    }
 
-int main() {
 #include <string>
 
     string code = R"(program Example;
@@ -36,4 +177,4 @@ int main() {
     vector<Token> tokens = lexer.tokenize();
     for (Token tk : tokens) cout << tk.value << ' ' << (int)tk.type << '\n';
     return 0;
-}
\ No newline at end of file
+}
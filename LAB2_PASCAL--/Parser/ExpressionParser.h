@@ -0,0 +1,194 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <charconv>
+#include <system_error>
+#include "../Base/Token.h"
+#include "../Base/Program.h"
+
+using namespace std;
+
+// Разбор выражения методом Пратта (подъём по приоритетам) в дерево Expr
+// в арене программы. Вход - лексемы одного выражения; имена и строки
+// копируются в арену, так что лексемы после разбора не нужны.
+// Приоритеты те же, что у PostfixConverter: унарный минус, затем * / div mod,
+// затем + -, все бинарные операции левоассоциативны.
+class ExpressionParser {
+private:
+    Arena& arena;
+    const TokenView* current;
+    const TokenView* end;
+
+    static int precedence(TokenTypes type) {
+        switch (type) {
+        case TokenTypes::PLUS:
+        case TokenTypes::MINUS:
+            return 1;
+        case TokenTypes::MULTIPLY:
+        case TokenTypes::DIVIDE:
+        case TokenTypes::KEYWORD_DIV:
+        case TokenTypes::KEYWORD_MOD:
+            return 2;
+        default:
+            return 0;
+        }
+    }
+
+    static string position(const TokenView& token) {
+        return " at line " + to_string(token.line) + ", column " + to_string(token.column);
+    }
+
+    Expr* parsePrefix() {
+        if (current == end) {
+            throw runtime_error("Expected an operand at the end of expression");
+        }
+        const TokenView& token = *current++;
+        switch (token.type) {
+        case TokenTypes::MINUS:
+            return arena.make<UnaryExpr>(Expr{ ExpressionKind::NEGATE, TokenTypes::MINUS }, parsePrefix());
+        case TokenTypes::LEFT_PAREN: {
+            Expr* inner = parseBinary(1);
+            if (current == end) {
+                throw runtime_error("One or more opening parentheses are not paired");
+            }
+            if (current->type != TokenTypes::RIGHT_PAREN) {
+                throw runtime_error("Unexpected token '" + string(current->lexeme) + "' in expression" + position(*current));
+            }
+            current++;
+            return inner;
+        }
+        case TokenTypes::INTEGER_LITERAL:
+        case TokenTypes::DOUBLE_LITERAL: {
+            if (isnan(token.number)) {
+                throw runtime_error("Invalid numeric literal: " + string(token.lexeme));
+            }
+            if (token.type == TokenTypes::INTEGER_LITERAL) {
+                // целое читается из текста точно, а не через double
+                int64_t integer;
+                const char* last = token.lexeme.data() + token.lexeme.size();
+                auto parsed = from_chars(token.lexeme.data(), last, integer);
+                if (parsed.ec == errc() && parsed.ptr == last) {
+                    return arena.make<LiteralExpr>(Expr{ ExpressionKind::LITERAL }, Value::fromInteger(integer));
+                }
+            }
+            // целое за пределами int64 остаётся вещественным числом
+            return arena.make<LiteralExpr>(Expr{ ExpressionKind::LITERAL }, Value::fromReal(token.number));
+        }
+        case TokenTypes::STRING_LITERAL: {
+            return arena.make<LiteralExpr>(Expr{ ExpressionKind::LITERAL }, Value::fromText(arena.copy(token.lexeme)));
+        }
+        case TokenTypes::IDENTIFIER:
+            return arena.make<IdentifierExpr>(Expr{ ExpressionKind::IDENTIFIER }, Name{ arena.copy(token.lexeme), token.symbol });
+        case TokenTypes::RIGHT_PAREN:
+            throw runtime_error("Closing parenthesis is not matched" + position(token));
+        default:
+            throw runtime_error("Unexpected token '" + string(token.lexeme) + "' in expression" + position(token));
+        }
+    }
+
+    Expr* parseBinary(int minPrecedence) {
+        Expr* left = parsePrefix();
+        while (current != end && precedence(current->type) >= minPrecedence) {
+            TokenTypes op = current->type;
+            current++;
+            Expr* right = parseBinary(precedence(op) + 1);
+            left = arena.make<BinaryExpr>(Expr{ ExpressionKind::BINARY, op }, left, right);
+        }
+        return left;
+    }
+
+    ExpressionParser(Arena& target, const TokenView* begin, const TokenView* finish) : arena(target), current(begin), end(finish) {}
+
+public:
+    static bool isComparison(TokenTypes type) {
+        return type == TokenTypes::EQUAL || type == TokenTypes::NON_EQUAL || type == TokenTypes::GREATER
+            || type == TokenTypes::LESS || type == TokenTypes::GREATER_OR_EQUAL || type == TokenTypes::LESS_OR_EQUAL;
+    }
+
+    // все лексемы [begin, end) - одно выражение
+    static Expr* parse(Arena& arena, const TokenView* begin, const TokenView* end) {
+        if (begin == end) {
+            throw runtime_error("Expected an expression");
+        }
+        ExpressionParser parser(arena, begin, end);
+        Expr* expression = parser.parseBinary(1);
+        if (parser.current != end) {
+            if (parser.current->type == TokenTypes::RIGHT_PAREN) {
+                throw runtime_error("Closing parenthesis is not matched" + position(*parser.current));
+            }
+            throw runtime_error("Unexpected token '" + string(parser.current->lexeme) + "' in expression" + position(*parser.current));
+        }
+        return expression;
+    }
+
+    // Список аргументов Write: выражения через запятую, без скобок и сравнений.
+    // Тексты ошибок - те же, что выдавал Interpreter при разборе списка.
+    static Span<Expr*> parseArguments(Arena& arena, const TokenView* begin, const TokenView* end) {
+        vector<Expr*> arguments;
+        const TokenView* argument = begin;
+        for (const TokenView* token = begin; token != end; token++) {
+            switch (token->type) {
+            case TokenTypes::COMMA:
+                if (token == begin)
+                    throw runtime_error("Syntax Error in Write statement: The argument list cannot start with a comma");
+                if (token == argument)
+                    throw runtime_error("Syntax Error in Write statement: Multiple consecutive commas are not allowed");
+                arguments.push_back(parseArgument(arena, argument, token));
+                argument = token + 1;
+                break;
+            case TokenTypes::IDENTIFIER:
+            case TokenTypes::INTEGER_LITERAL:
+            case TokenTypes::DOUBLE_LITERAL:
+            case TokenTypes::STRING_LITERAL:
+            case TokenTypes::PLUS:
+            case TokenTypes::MINUS:
+            case TokenTypes::MULTIPLY:
+            case TokenTypes::DIVIDE:
+            case TokenTypes::KEYWORD_DIV:
+            case TokenTypes::KEYWORD_MOD:
+                break;
+            default:
+                throw runtime_error("Syntax Error in Write statement: Unexpected token '" + string(token->lexeme) + "' in the argument list");
+            }
+        }
+        if (argument == end && argument != begin)
+            throw runtime_error("Syntax Error in Write statement: The argument list cannot end with a comma");
+        if (argument != end)
+            arguments.push_back(parseArgument(arena, argument, end));
+        return arena.copy(arguments);
+    }
+
+    // Условие if: ровно одно сравнение двух выражений
+    static Expr* parseCondition(Arena& arena, const TokenView* begin, const TokenView* end) {
+        const TokenView* sign = nullptr;
+        for (const TokenView* token = begin; token != end; token++) {
+            if (isComparison(token->type)) {
+                if (sign)
+                    throw runtime_error("Syntax Error in conditional expression: Multiple comparison operators ('=', '<>', '<', '<=', '>', '>=') found");
+                sign = token;
+            }
+        }
+        if (!sign)
+            throw runtime_error("Syntax Error in conditional expression: Must be comparison operator!");
+        try {
+            Expr* left = parse(arena, begin, sign);
+            Expr* right = parse(arena, sign + 1, end);
+            return arena.make<BinaryExpr>(Expr{ ExpressionKind::COMPARISON, sign->type }, left, right);
+        }
+        catch (const runtime_error& e) {
+            throw runtime_error("Invalid condition expression: " + string(e.what()));
+        }
+    }
+
+private:
+    static Expr* parseArgument(Arena& arena, const TokenView* begin, const TokenView* end) {
+        try {
+            return parse(arena, begin, end);
+        }
+        catch (const runtime_error& e) {
+            throw runtime_error("Runtime Error in Write statement: Could not evaluate the expression: " + string(e.what()));
+        }
+    }
+};
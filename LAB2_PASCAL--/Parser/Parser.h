@@ -7,200 +7,199 @@
 #include <exception>
 #include "../Base/Token.h"
 #include "../Base/Node.h"
+#include "../Base/Program.h"
+#include "TokenCursor.h"
+#include "ExpressionParser.h"
+#include "ProgramLowering.h"
 #include <list>
 #include <set>
 #include <memory>
+#include <limits>
+#include <algorithm>
 
 using namespace std;
 
 class Parser {
 private:
-    vector<Token> tokens;
+    unique_ptr<TokenCursor> cursor;
+    Program program;
     list<list<shared_ptr<Node>>> ast;
-    int curTokenPos = 0;
-    list<shared_ptr<Node>>* currentBlock = nullptr;
+    // Операторы ещё не законченных блоков, внутренние - в конце. Закрытый
+    // блок переносится из хвоста в арену одним массивом.
+    vector<Statement*> pending;
+    // лексемы текущего выражения; после разбора в дерево они не нужны
+    vector<Token> expression;
+    // сохранять ли лексемы выражений в операторах - нужно только для parse()
+    bool keepTokens = false;
+
+    const Token& peek() const {
+        return cursor->token();
+    }
 
-    Token peek() const {
-        if (curTokenPos < tokens.size()) {
-            return tokens[curTokenPos];
-        }
-        return Token(TokenTypes::UNKNOWN, "", -1, -1);
+    TokenTypes peekType() const {
+        return cursor->type(0);
     }
 
     TokenTypes getNextTokenTypes() const {
-        if (curTokenPos + 1 < tokens.size()) {
-            return tokens[curTokenPos + 1].type;
-        }
-        return TokenTypes::UNKNOWN;
+        return cursor->type(1);
     }
 
     Token pass() {
         Token current = peek();
-        if (curTokenPos < tokens.size()) {
-            curTokenPos++;
-        }
+        cursor->advance();
         return current;
     }
 
-    optional<Token> match(vector<TokenTypes> tts) {
-        if (curTokenPos < tokens.size()) {
-            Token curToken = tokens[curTokenPos];
+    optional<Token> match(initializer_list<TokenTypes> tts) {
+        if (!cursor->atEnd()) {
+            TokenTypes curType = peekType();
             for (TokenTypes tt : tts) {
-                if (curToken.type == tt) {
-                    curTokenPos++;
-                    return curToken;
+                if (curType == tt) {
+                    return pass();
                 }
             }
         }
         return nullopt;
     }
 
-    Token require(vector<TokenTypes> tts, const string& errorMessage) {
+    Token require(initializer_list<TokenTypes> tts, const string& errorMessage) {
         optional<Token> tk = match(tts);
         if (tk.has_value())
             return tk.value();
         throw runtime_error("Expected: " + errorMessage);
     }
 
-    void addNode(shared_ptr<Node> node) {
-        if (currentBlock) {
-            currentBlock->push_back(node);
-        }
-        else {
-            ast.push_back({ node });
-            currentBlock = &ast.back();
-        }
+    Name nameOf(const Token& identifier) {
+        return Name{ program.arena.copy(identifier.value), identifier.symbol };
     }
 
-    void startNewBlock() {
-        ast.push_back({});
-        currentBlock = &ast.back();
+    Span<Statement*> closeBlock(size_t blockStart) {
+        Span<Statement*> block = program.arena.array<Statement*>(pending.size() - blockStart);
+        copy(pending.begin() + blockStart, pending.end(), block.begin());
+        pending.resize(blockStart);
+        return block;
     }
 
-    void parseProgram() {
+    void parseSource() {
         require({ TokenTypes::KEYWORD_PROGRAM }, "'program'");
         Token programName = require({ TokenTypes::IDENTIFIER }, "'program name'");
-        addNode(make_shared<ProgramNode>(programName.value));
+        program.name = program.arena.copy(programName.value);
         require({ TokenTypes::SEMICOLON }, "';'");
 
-        if (peek().type == TokenTypes::KEYWORD_CONST) {
-            startNewBlock();
-            addNode(make_shared<ConstSectionNode>());
+        if (peekType() == TokenTypes::KEYWORD_CONST) {
+            program.hasConstSection = true;
             parseConstDeclarations();
+            program.constSection = closeBlock(0);
         }
 
-        if (peek().type == TokenTypes::KEYWORD_VAR) {
-            startNewBlock();
-            addNode(make_shared<VarSectionNode>());
+        if (peekType() == TokenTypes::KEYWORD_VAR) {
+            program.hasVarSection = true;
             parseVarDeclarations();
+            program.varSection = closeBlock(0);
         }
 
-        startNewBlock();
-        addNode(make_shared<BeginSectionNode>());
         parseBeginStatement();
+        program.body = closeBlock(0);
 
         require({ TokenTypes::END_OF_PROGRAM }, "'end.'");
     }
 
     void parseConstDeclarations() {
         require({ TokenTypes::KEYWORD_CONST }, "'const'");
-        while (peek().type == TokenTypes::IDENTIFIER) {
+        while (peekType() == TokenTypes::IDENTIFIER) {
             parseConstDeclaration();
         }
 
-        if (peek().type != TokenTypes::KEYWORD_VAR && peek().type != TokenTypes::KEYWORD_BEGIN) {
+        if (peekType() != TokenTypes::KEYWORD_VAR && peekType() != TokenTypes::KEYWORD_BEGIN) {
             throw runtime_error("Syntax Error: Expected 'var' or 'begin' after constant declarations, but got " + peek().value);
         }
     }
 
     void parseConstDeclaration() {
         Token identifier = require({ TokenTypes::IDENTIFIER }, "constant identifier");
-        auto constDeclNode = make_shared<ConstDeclarationNode>(identifier.value);
         require({ TokenTypes::COLON }, "':'");
-        constDeclNode->type = parseTypeSpecifier();
+        ValueType declared = parseTypeSpecifier();
         require({ TokenTypes::EQUAL }, "'='");
-        constDeclNode->value = parseLiteral();
-        currentBlock->push_back(constDeclNode);
+        Value value = parseLiteral();
+        pending.push_back(program.arena.make<ConstStatement>(Statement{ Node::NodeType::CONST_DECLARATION }, nameOf(identifier), declared, value));
         require({ TokenTypes::SEMICOLON }, "';'");
     }
 
     void parseVarDeclarations() {
         require({ TokenTypes::KEYWORD_VAR }, "'var'");
-        while (peek().type == TokenTypes::IDENTIFIER) {
+        while (peekType() == TokenTypes::IDENTIFIER) {
             parseVarDeclaration();
         }
 
-        if (peek().type != TokenTypes::KEYWORD_BEGIN) {
+        if (peekType() != TokenTypes::KEYWORD_BEGIN) {
             throw runtime_error("Syntax Error: Expected 'begin' after variable declarations, but got " + peek().value);
         }
     }
 
     void parseVarDeclaration() {
-        auto varDeclNode = make_shared<VariableDeclarationNode>();
-        varDeclNode->identifierList = parseIdentifierList();
+        Span<Name> names = parseIdentifierList();
         require({ TokenTypes::COLON }, "':'");
-        varDeclNode->type = parseTypeSpecifier();
-        currentBlock->push_back(varDeclNode);
+        ValueType declared = parseTypeSpecifier();
+        pending.push_back(program.arena.make<VarStatement>(Statement{ Node::NodeType::VARIABLE_DECLARATION }, names, declared));
         require({ TokenTypes::SEMICOLON }, "';'");
     }
 
-    shared_ptr<IdentifierListNode> parseIdentifierList() {
-        auto idListNode = make_shared<IdentifierListNode>();
+    Span<Name> parseIdentifierList() {
+        vector<Name> names;
         Token identifier = require({ TokenTypes::IDENTIFIER }, "identifier");
-        idListNode->identifiers.push_back(identifier.value);
+        names.push_back(nameOf(identifier));
         while (match({ TokenTypes::COMMA })) {
             identifier = require({ TokenTypes::IDENTIFIER }, "identifier");
-            idListNode->identifiers.push_back(identifier.value);
+            names.push_back(nameOf(identifier));
         }
-        return idListNode;
+        return program.arena.copy(names);
     }
-    string parseTypeSpecifier() {
+
+    ValueType parseTypeSpecifier() {
         if (match({ TokenTypes::KEYWORD_INTEGER }))
-            return "integer";
+            return ValueType::INTEGER;
         else if (match({ TokenTypes::KEYWORD_DOUBLE }))
-            return "double";
+            return ValueType::DOUBLE;
         else if (match({ TokenTypes::KEYWORD_STRING }))
-            return "string";
+            return ValueType::STRING;
         throw runtime_error("Syntax Error: Expected 'integer', 'double' or 'string' but got " + peek().value);
     }
 
-    variant<int, double, string> parseLiteral() {
+    Value parseLiteral() {
         if (auto intToken = match({ TokenTypes::INTEGER_LITERAL })) {
-            return stoi(intToken->value);
-        }
-        else if (auto doubleToken = match({ TokenTypes::DOUBLE_LITERAL })) {
-            return stod(doubleToken->value);
-        }
-        else if (auto stringToken = match({ TokenTypes::STRING_LITERAL })) {
-            string value = stringToken->value;
-            return value;
-        }
-        else {
-            throw runtime_error("Syntax Error: Expected a literal but got " + peek().value);
+            if (intToken->number > numeric_limits<int>::max()) {
+                throw runtime_error("Syntax Error: Integer constant is out of range: " + intToken->value);
+            }
+            return Value::fromInteger(static_cast<int>(intToken->number));
         }
+        if (auto doubleToken = match({ TokenTypes::DOUBLE_LITERAL }))
+            return Value::fromReal(doubleToken->number);
+        if (auto stringToken = match({ TokenTypes::STRING_LITERAL }))
+            return Value::fromText(program.arena.copy(stringToken->value));
+        throw runtime_error("Syntax Error: Expected a literal but got " + peek().value);
     }
 
     void parseBeginStatement() {
         require({ TokenTypes::KEYWORD_BEGIN }, "'begin'");
-        while (peek().type != TokenTypes::END_OF_PROGRAM && peek().type != TokenTypes::KEYWORD_END) {
+        while (peekType() != TokenTypes::END_OF_PROGRAM && peekType() != TokenTypes::KEYWORD_END) {
             parseStatement();
         }
-        if (peek().type != TokenTypes::END_OF_PROGRAM) {
+        if (peekType() != TokenTypes::END_OF_PROGRAM) {
             require({ TokenTypes::KEYWORD_END }, "'end'");
         }
     }
 
     void parseStatement() {
-        if (peek().type == TokenTypes::IDENTIFIER) {
+        if (peekType() == TokenTypes::IDENTIFIER) {
             parseAssignmentStatement();
         }
-        else if (peek().type == TokenTypes::KEYWORD_WRITE) {
+        else if (peekType() == TokenTypes::KEYWORD_WRITE) {
             parseWriteStatement();
         }
-        else if (peek().type == TokenTypes::KEYWORD_READ) {
+        else if (peekType() == TokenTypes::KEYWORD_READ) {
             parseReadStatement();
         }
-        else if (peek().type == TokenTypes::KEYWORD_IF) {
+        else if (peekType() == TokenTypes::KEYWORD_IF) {
             parseIfStatement();
         }
         else {
@@ -219,21 +218,21 @@ private:
         };
 
         Token identifier = require({ TokenTypes::IDENTIFIER }, "variable identifier");
-        auto assignNode = make_shared<AssignmentStatementNode>(identifier.value);
         require({ TokenTypes::ASSIGN }, "':='");
-        while (peek().type != TokenTypes::SEMICOLON) {
-            if (unexpectedTokens.count(peek().type)) {
+        expression.clear();
+        while (peekType() != TokenTypes::SEMICOLON) {
+            if (unexpectedTokens.count(peekType())) {
                 throw runtime_error("Syntax Error: Expected ';' after assignment for variable '" + identifier.value + "' at line " + to_string(identifier.line) + ", column " + to_string(identifier.column));
             }
-            if (peek().type == TokenTypes::IDENTIFIER && getNextTokenTypes() == TokenTypes::ASSIGN) {
+            if (peekType() == TokenTypes::IDENTIFIER && getNextTokenTypes() == TokenTypes::ASSIGN) {
                 throw runtime_error("Syntax Error: Expected ';' after assignment for variable '" + identifier.value + "' at line " + to_string(identifier.line) + ", column " + to_string(identifier.column));
             }
-            assignNode->expression.push_back(pass());
+            expression.push_back(pass());
         }
-        if (assignNode->expression.empty()) {
+        if (expression.empty()) {
             throw runtime_error("Syntax Error: Expected an expression after ':=' for variable '" + identifier.value + "' at line " + to_string(identifier.line) + ", column " + to_string(identifier.column));
         }
-        currentBlock->push_back(assignNode);
+        pending.push_back(ProgramLowering::makeAssignment(program, nameOf(identifier), expression, keepTokens));
         require({ TokenTypes::SEMICOLON }, "';'");
     }
 
@@ -252,33 +251,31 @@ private:
         };
 
         require({ TokenTypes::KEYWORD_WRITE }, "'Write'");
-        auto writeNode = make_shared<WriteStatementNode>();
         require({ TokenTypes::LEFT_PAREN }, "'('");
+        expression.clear();
         while (getNextTokenTypes() != TokenTypes::RIGHT_PAREN) {
-            if (unexpectedTokensInWrite.count(peek().type)) 
+            if (unexpectedTokensInWrite.count(peekType())) 
                 throw runtime_error("Syntax Error in Write statement: Unexpected token '" + peek().value + "' within the argument list at line " 
                     + to_string(peek().line) + ", column " + to_string(peek().column) + ". Expected an expression or ')'.");
-            writeNode->expression.push_back(pass());
+            expression.push_back(pass());
         }
-        writeNode->expression.push_back(pass());
+        expression.push_back(pass());
         require({ TokenTypes::RIGHT_PAREN }, "')'");
         require({ TokenTypes::SEMICOLON }, "';'");
-        currentBlock->push_back(writeNode);
+        pending.push_back(ProgramLowering::makeWrite(program, expression, keepTokens));
     }
 
     void parseReadStatement() {
         require({ TokenTypes::KEYWORD_READ }, "'Read'");
-        auto readNode = make_shared<ReadStatementNode>();
         require({ TokenTypes::LEFT_PAREN }, "'('");
-        readNode->identifierList = parseIdentifierList();
+        Span<Name> targets = parseIdentifierList();
         require({ TokenTypes::RIGHT_PAREN }, "')'");
         require({ TokenTypes::SEMICOLON }, "';'");
-        currentBlock->push_back(readNode);
+        pending.push_back(program.arena.make<ReadStatement>(Statement{ Node::NodeType::READ_STATEMENT }, targets));
     }
 
     void parseIfStatement() {
         require({ TokenTypes::KEYWORD_IF }, "'if'");
-        auto ifNode = make_shared<IfStatementNode>();
         require({ TokenTypes::LEFT_PAREN }, "'('");
 
         static const set<TokenTypes> unexpectedTokensCondition = {
@@ -290,38 +287,37 @@ private:
             TokenTypes::KEYWORD_IF,
             TokenTypes::KEYWORD_END,
             TokenTypes::END_OF_PROGRAM,
-            TokenTypes::SEMICOLON //    
+            TokenTypes::SEMICOLON // преждевременная точка с запятой
         };
 
-        while (peek().type != TokenTypes::RIGHT_PAREN) {
-            if (unexpectedTokensCondition.count(peek().type)) {
+        expression.clear();
+        while (peekType() != TokenTypes::RIGHT_PAREN) {
+            if (unexpectedTokensCondition.count(peekType())) {
                 throw runtime_error("Syntax Error: Expected ')' after 'if' condition at line " + to_string(peek().line) + ", column " + to_string(peek().column));
             }
-            ifNode->condition.push_back(pass());
-            if (curTokenPos >= tokens.size()) {
+            expression.push_back(pass());
+            if (cursor->atEnd()) {
                 throw runtime_error("Syntax Error: Unexpected end of input while parsing 'if' condition.");
             }
         }
         require({ TokenTypes::RIGHT_PAREN }, "')'");
+        IfStatement* ifStatement = ProgramLowering::makeIf(program, expression, keepTokens);
         require({ TokenTypes::KEYWORD_THEN }, "'then'");
-        ifNode->thenStatement = parseStatementBlock();
+        ifStatement->thenBranch = parseStatementBlock(ifStatement->thenBlock);
         if (match({ TokenTypes::KEYWORD_ELSE })) {
-            ifNode->elseStatement = parseStatementBlock();
+            ifStatement->elseBranch = parseStatementBlock(ifStatement->elseBlock);
         }
-        currentBlock->push_back(ifNode);
+        pending.push_back(ifStatement);
     }
 
-    list<shared_ptr<Node>> parseStatementBlock() {
-        list<shared_ptr<Node>> block;
-        list<shared_ptr<Node>>* previousBlock = currentBlock;
-        currentBlock = &block;
-        if (peek().type == TokenTypes::KEYWORD_BEGIN) {
+    Span<Statement*> parseStatementBlock(bool& beginEnd) {
+        size_t blockStart = pending.size();
+        beginEnd = peekType() == TokenTypes::KEYWORD_BEGIN;
+        if (beginEnd) {
             require({ TokenTypes::KEYWORD_BEGIN }, "'begin'");
-            auto beginNode = make_shared<BeginSectionNode>();
-            block.push_back(beginNode);
-            while (peek().type != TokenTypes::KEYWORD_END) {
+            while (peekType() != TokenTypes::KEYWORD_END) {
                 parseStatement();
-                if (peek().type == TokenTypes::SEMICOLON) {
+                if (peekType() == TokenTypes::SEMICOLON) {
                     pass();
                 }
             }
@@ -330,15 +326,34 @@ private:
         else {
             parseStatement();
         }
-        currentBlock = previousBlock;
-        return block;
+        return closeBlock(blockStart);
     }
 
 public:
-    Parser(const vector<Token>& tkns) : tokens(tkns) {};
+    Parser(const vector<Token>& tkns) : cursor(make_unique<VectorTokenCursor>(tkns)) {};
 
+    Parser(vector<Token>&& tkns) : cursor(make_unique<VectorTokenCursor>(move(tkns))) {};
+
+    // Потоковый разбор: лексемы берутся из лексера по мере надобности,
+    // лексер должен жить до конца parse()
+    Parser(Lexer& lexer) : cursor(make_unique<StreamTokenCursor>(lexer)) {};
+
+    // Лексемы в компактном виде из Lexer::tokenizeBuffer()
+    Parser(TokenBuffer tkns) : cursor(make_unique<BufferTokenCursor>(move(tkns))) {};
+
+    // списочное дерево Node, как раньше
     list<list<shared_ptr<Node>>>& parse() {
-        parseProgram();
+        keepTokens = true;
+        parseSource();
+        ast = program.toNodes();
         return ast;
     }
+
+    // Дерево в арене; Parser после этого не нужен. С withTokens операторы
+    // сохраняют и лексемы выражений - тогда toNodes() даст полные списки.
+    Program parseProgram(bool withTokens = false) {
+        keepTokens = withTokens;
+        parseSource();
+        return move(program);
+    }
 };
\ No newline at end of file
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include "../Base/Token.h"
+#include "../Base/Node.h"
+#include "../Base/Program.h"
+#include "ExpressionParser.h"
+
+using namespace std;
+
+// Построение операторов Program из лексем выражений и перевод списочного
+// дерева Node в Program (обратный Program::toNodes). Нужен только разбор
+// выражений, без лексера и курсоров Parser, поэтому Interpreter может
+// принимать списочное дерево, не завися от Parser.
+class ProgramLowering {
+private:
+    static vector<TokenView> viewsOf(const vector<Token>& tokens) {
+        vector<TokenView> views;
+        views.reserve(tokens.size());
+        for (const Token& token : tokens) {
+            TokenView view(token.type, token.value, token.line, token.column);
+            view.symbol = token.symbol;
+            view.hash = token.hash;
+            view.number = token.number;
+            views.push_back(view);
+        }
+        return views;
+    }
+
+    static Span<TokenView> copyTokens(Program& program, const vector<Token>& tokens) {
+        Span<TokenView> span = program.arena.array<TokenView>(tokens.size());
+        for (size_t i = 0; i < tokens.size(); i++) {
+            span[i] = program.copyToken(tokens[i]);
+        }
+        return span;
+    }
+
+    static Span<Name> namesOf(Program& program, const shared_ptr<Node>& node) {
+        auto idList = nodeCast<IdentifierListNode>(node);
+        if (!idList) throw runtime_error("Internal Error: Could not cast node to IdentifierListNode.");
+        Span<Name> names = program.arena.array<Name>(idList->identifiers.size());
+        size_t i = 0;
+        for (const string& identifier : idList->identifiers) {
+            names[i++] = Name{ program.arena.copy(identifier) };
+        }
+        return names;
+    }
+
+    static Span<Statement*> fromNodeBlock(Program& program, const list<shared_ptr<Node>>& block, bool& beginEnd) {
+        vector<Statement*> statements;
+        beginEnd = false;
+        for (const auto& node : block) {
+            if (node->type == Node::NodeType::BEGIN_SECTION) {
+                beginEnd = true;
+            }
+            else if (Statement* statement = fromNode(program, node)) {
+                statements.push_back(statement);
+            }
+        }
+        return program.arena.copy(statements);
+    }
+
+    // узлы разделов и заголовка программы не исполняются - для них nullptr
+    static Statement* fromNode(Program& program, const shared_ptr<Node>& node) {
+        Arena& arena = program.arena;
+        switch (node->type) {
+        case Node::NodeType::CONST_DECLARATION: {
+            auto decl = nodeCast<ConstDeclarationNode>(node);
+            if (!decl) throw runtime_error("Internal Error: Could not cast node to ConstDeclarationNode.");
+            Value value;
+            switch (decl->value.index()) {
+            case 0: value = Value::fromInteger(get<int>(decl->value)); break;
+            case 1: value = Value::fromReal(get<double>(decl->value)); break;
+            default: value = Value::fromText(arena.copy(get<string>(decl->value))); break;
+            }
+            ValueType declared = value.type();
+            parseTypeName(decl->type, declared);
+            return arena.make<ConstStatement>(Statement{ node->type }, Name{ arena.copy(decl->identifier) }, declared, value);
+        }
+        case Node::NodeType::VARIABLE_DECLARATION: {
+            auto decl = nodeCast<VariableDeclarationNode>(node);
+            if (!decl) throw runtime_error("Internal Error: Could not cast node to VariableDeclarationNode.");
+            ValueType declared;
+            if (!parseTypeName(decl->type, declared))
+                throw runtime_error("Unknown type: " + decl->type);
+            return arena.make<VarStatement>(Statement{ node->type }, namesOf(program, decl->identifierList), declared);
+        }
+        case Node::NodeType::ASSIGNMENT_STATEMENT: {
+            auto assign = nodeCast<AssignmentStatementNode>(node);
+            if (!assign) throw runtime_error("Internal Error: Could not cast node to AssignmentStatementNode.");
+            return makeAssignment(program, Name{ arena.copy(assign->variableName) }, assign->expression, false);
+        }
+        case Node::NodeType::WRITE_STATEMENT: {
+            auto write = nodeCast<WriteStatementNode>(node);
+            if (!write) throw runtime_error("Internal Error: Could not cast node to WriteStatementNode.");
+            return makeWrite(program, write->expression, false);
+        }
+        case Node::NodeType::READ_STATEMENT: {
+            auto read = nodeCast<ReadStatementNode>(node);
+            if (!read) throw runtime_error("Internal Error: Could not cast node to ReadStatementNode.");
+            return arena.make<ReadStatement>(Statement{ node->type }, namesOf(program, read->identifierList));
+        }
+        case Node::NodeType::IF_STATEMENT: {
+            auto ifNode = nodeCast<IfStatementNode>(node);
+            if (!ifNode) throw runtime_error("Internal Error: Could not cast node to IfStatementNode.");
+            IfStatement* ifStatement = makeIf(program, ifNode->condition, false);
+            ifStatement->thenBranch = fromNodeBlock(program, ifNode->thenStatement, ifStatement->thenBlock);
+            ifStatement->elseBranch = fromNodeBlock(program, ifNode->elseStatement, ifStatement->elseBlock);
+            return ifStatement;
+        }
+        default:
+            return nullptr;
+        }
+    }
+
+public:
+    // Операторы с выражениями. Ошибка в выражении не прерывает разбор
+    // программы: она сохраняется в операторе и выдаётся при его исполнении.
+    static AssignStatement* makeAssignment(Program& program, Name target, const vector<Token>& tokens, bool keepTokens) {
+        auto assign = program.arena.make<AssignStatement>(Statement{ Node::NodeType::ASSIGNMENT_STATEMENT }, target);
+        vector<TokenView> views = viewsOf(tokens);
+        try {
+            assign->value = ExpressionParser::parse(program.arena, views.data(), views.data() + views.size());
+        }
+        catch (const runtime_error& e) {
+            assign->error = program.arena.copy("Failed to assign " + string(target.text) + ": " + e.what());
+        }
+        if (keepTokens) {
+            assign->tokens = copyTokens(program, tokens);
+        }
+        return assign;
+    }
+
+    static WriteStatement* makeWrite(Program& program, const vector<Token>& tokens, bool keepTokens) {
+        auto write = program.arena.make<WriteStatement>(Statement{ Node::NodeType::WRITE_STATEMENT });
+        vector<TokenView> views = viewsOf(tokens);
+        try {
+            write->arguments = ExpressionParser::parseArguments(program.arena, views.data(), views.data() + views.size());
+        }
+        catch (const runtime_error& e) {
+            write->error = program.arena.copy(e.what());
+        }
+        if (keepTokens) {
+            write->tokens = copyTokens(program, tokens);
+        }
+        return write;
+    }
+
+    // ветки заполняет вызывающий
+    static IfStatement* makeIf(Program& program, const vector<Token>& tokens, bool keepTokens) {
+        auto ifStatement = program.arena.make<IfStatement>(Statement{ Node::NodeType::IF_STATEMENT });
+        vector<TokenView> views = viewsOf(tokens);
+        try {
+            ifStatement->condition = ExpressionParser::parseCondition(program.arena, views.data(), views.data() + views.size());
+        }
+        catch (const runtime_error& e) {
+            ifStatement->error = program.arena.copy(e.what());
+        }
+        if (keepTokens) {
+            ifStatement->tokens = copyTokens(program, tokens);
+        }
+        return ifStatement;
+    }
+
+    // Перевод готового списочного дерева в Program с разбором выражений.
+    // Как и Interpreter раньше, первый блок (заголовок программы) не исполняется.
+    static Program fromNodes(const list<list<shared_ptr<Node>>>& ast) {
+        Program program;
+        if (ast.empty()) {
+            return program;
+        }
+        if (auto header = ast.front().empty() ? nullptr : nodeCast<ProgramNode>(ast.front().front())) {
+            program.name = program.arena.copy(header->programName);
+        }
+        vector<Statement*> constants, variables, statements;
+        for (auto block = next(ast.begin()); block != ast.end(); block++) {
+            vector<Statement*>* section = &statements;
+            if (!block->empty() && block->front()->type == Node::NodeType::CONST_SECTION) {
+                program.hasConstSection = true;
+                section = &constants;
+            }
+            else if (!block->empty() && block->front()->type == Node::NodeType::VAR_SECTION) {
+                program.hasVarSection = true;
+                section = &variables;
+            }
+            for (const auto& node : *block) {
+                if (Statement* statement = fromNode(program, node)) {
+                    section->push_back(statement);
+                }
+            }
+        }
+        program.constSection = program.arena.copy(constants);
+        program.varSection = program.arena.copy(variables);
+        program.body = program.arena.copy(statements);
+        return program;
+    }
+};
@@ -2,12 +2,186 @@
 #include "../Base/Node.h"
 #include "Parser.h"
 #include <chrono>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <algorithm>
 #include <vector>
 #include "../Base/Token.h"
 #include "../Lexer/Lexer.h"
+#include "../Base/SourceBuffer.cpp"
 
-int main()
+// учёт живой и пиковой памяти в куче для бенчмарков
+static size_t liveBytes = 0;
+static size_t peakBytes = 0;
+static const size_t headerSize = alignof(std::max_align_t);
+
+void* operator new(size_t size) {
+	char* block = static_cast<char*>(malloc(size + headerSize));
+	if (!block)
+		throw std::bad_alloc();
+	*reinterpret_cast<size_t*>(block) = size;
+	liveBytes += size;
+	peakBytes = std::max(peakBytes, liveBytes);
+	return block + headerSize;
+}
+
+void operator delete(void* ptr) noexcept {
+	if (!ptr)
+		return;
+	char* block = static_cast<char*>(ptr) - headerSize;
+	liveBytes -= *reinterpret_cast<size_t*>(block);
+	free(block);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	operator delete(ptr);
+}
+
+std::string generateProgram(int statements) {
+	std::string code = "program Generated;\nvar\n    counter, total, index_value: integer;\nbegin\n";
+	for (int i = 0; i < statements; i++) {
+		code += "    counter := (total + " + std::to_string(i) + ") * 2 div 3;\n";
+		code += "    if (counter > index_value) then\n        total := total - counter;\n";
+	}
+	return code + "end.";
+}
+
+template <typename Func>
+void measureParse(const std::string& name, Func func) {
+	size_t liveBefore = liveBytes;
+	peakBytes = liveBytes;
+	auto start = std::chrono::high_resolution_clock::now();
+	func();
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time = end - start;
+	cout << name << ": " << time.count() << " s, peak heap " << (peakBytes - liveBefore) / (1024 * 1024) << " MB\n";
+}
+
+// дерево в арене против списков shared_ptr<Node>: память на байт исходника и время
+void benchmarkArena(const std::string& code) {
+	auto start = std::chrono::high_resolution_clock::now();
+	Lexer lexer(code);
+	Parser parser(lexer);
+	Program program = parser.parseProgram();
+	auto parsed = std::chrono::high_resolution_clock::now();
+
+	// списки строятся из дерева с сохранёнными лексемами выражений
+	Lexer tokensLexer(code);
+	Parser tokensParser(tokensLexer);
+	Program withTokens = tokensParser.parseProgram(true);
+	auto converting = std::chrono::high_resolution_clock::now();
+	size_t liveBefore = liveBytes;
+	auto nodes = withTokens.toNodes();
+	size_t listBytes = liveBytes - liveBefore;
+	auto converted = std::chrono::high_resolution_clock::now();
+
+	size_t checksum = 0;
+	for (int round = 0; round < 20; round++)
+		for (const auto& block : nodes)
+			for (const auto& node : block)
+				checksum += size_t(node->type);
+	auto listWalked = std::chrono::high_resolution_clock::now();
+	for (int round = 0; round < 20; round++)
+		for (const Statement* statement : program.body)
+			checksum += size_t(statement->type);
+	auto arenaWalked = std::chrono::high_resolution_clock::now();
+
+	nodes.clear();
+	auto listFreed = std::chrono::high_resolution_clock::now();
+	size_t arenaBytes = program.arena.bytesReserved();
+	program = Program();
+	auto arenaFreed = std::chrono::high_resolution_clock::now();
+
+	std::chrono::duration<double> parseTime = parsed - start;
+	std::chrono::duration<double> listTime = converted - converting;
+	std::chrono::duration<double> listWalk = listWalked - converted;
+	std::chrono::duration<double> arenaWalk = arenaWalked - listWalked;
+	std::chrono::duration<double> listFree = listFreed - arenaWalked;
+	std::chrono::duration<double> arenaFree = arenaFreed - listFreed;
+	cout << "  AST: arena " << double(arenaBytes) / code.size() << " bytes/source byte, parse " << parseTime.count()
+		<< " s, free " << arenaFree.count() << " s, walk " << arenaWalk.count() << " s\n";
+	cout << "       lists " << double(listBytes) / code.size() << " bytes/source byte, build +" << listTime.count()
+		<< " s, free " << listFree.count() << " s, walk " << listWalk.count() << " s (checksum " << checksum << ")\n";
+}
+
+void runBenchmarks() {
+	for (int statements : { 20000, 80000 }) {
+		std::string code = generateProgram(statements);
+		cout << statements << " statements, " << code.size() / 1024 << " KB of source\n";
+		measureParse("  tokenize + parse", [&]() {
+			Lexer lexer(code);
+			std::vector<Token> tokens = lexer.tokenize();
+			Parser parser(tokens);
+			parser.parse();
+		});
+		measureParse("  streaming parse", [&]() {
+			Lexer lexer(code);
+			Parser parser(lexer);
+			parser.parse();
+		});
+		measureParse("  token buffer parse", [&]() {
+			Lexer lexer(code);
+			Parser parser(lexer.tokenizeBuffer());
+			parser.parse();
+		});
+		benchmarkArena(code);
+
+		// память самого потока лексем
+		Lexer lexer(code);
+		size_t liveBefore = liveBytes;
+		std::vector<Token> tokens = lexer.tokenize();
+		tokens.shrink_to_fit();
+		size_t vectorBytes = liveBytes - liveBefore;
+		TokenBuffer buffer = lexer.tokenizeBuffer();
+		cout << "  token stream: vector<Token> " << vectorBytes / tokens.size() << " bytes/token, TokenBuffer "
+			<< double(buffer.bytes()) / buffer.size() << " bytes/token\n";
+
+		// цикл peek/match парсера только по типам лексем
+		auto start = std::chrono::high_resolution_clock::now();
+		size_t checksum = 0;
+		for (int round = 0; round < 20; round++) {
+			for (const Token& token : tokens)
+				checksum += token.type == TokenTypes::SEMICOLON;
+		}
+		auto middle = std::chrono::high_resolution_clock::now();
+		for (int round = 0; round < 20; round++) {
+			for (size_t i = 0; i < buffer.size(); i++)
+				checksum += buffer.type(i) == TokenTypes::SEMICOLON;
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		std::chrono::duration<double> vectorScan = middle - start;
+		std::chrono::duration<double> bufferScan = end - middle;
+		cout << "  type scan: vector<Token> " << vectorScan.count() << " s, TokenBuffer " << bufferScan.count()
+			<< " s (checksum " << checksum << ")\n";
+	}
+}
+
+int main(int argc, char* argv[])
 {
+	if (argc > 1 && std::string(argv[1]) == "--bench") {
+		runBenchmarks();
+		return 0;
+	}
+
+	if (argc > 1) {
+		try {
+			std::string path = argv[1];
+			auto start_parse = std::chrono::high_resolution_clock::now();
+			Lexer lexer(path == "-" ? SourceBuffer::fromStream(std::cin) : SourceBuffer::fromFile(path));
+			Parser parser(lexer);
+			parser.parse();
+			auto end_parse = std::chrono::high_resolution_clock::now();
+			std::chrono::duration<double> parse_time = end_parse - start_parse;
+			cout << "Parsed " << lexer.source()->size() << " bytes in " << parse_time.count() << " s\n";
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Error: " << e.what() << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+
 	try {
 		string code = R"(program Example; 
 						const 
@@ -21,13 +195,13 @@ int main()
 							num1 := a + b - c;
 							num2 := 2;
 							num3 := num1;
-							Write("   : ", num1, num2, REs);
+							Write("Введите чётное целое число: ", num1, num2, REs);
 							RESULT := Pi;
 							Read(num3, num1);
 							Write(RESULT);
 							if (b mod 2) then
 							begin
-								Write(" = ", Res);
+								Write("Результат = ", Res);
 								if (a / b) then 
 								begin
 									a := b;
@@ -76,8 +250,8 @@ int main()
 						a := 5;
 						b := 5 * a + c + b;
 						c := a;
-						Write("   : ");
-						Write(" = ", Res);
+						Write("Введите четное целое число: ");
+						Write("Результат = ", Res);
 						Read(num2);
 						Read(num3, num1);
 						if (b + a) then
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include "../Base/Token.h"
+#include "../Base/TokenBuffer.h"
+#include "../Lexer/Lexer.h"
+
+using namespace std;
+
+// Окно просмотра для парсера: текущая лексема и тип следующей за ней.
+// За концом входа type() возвращает UNKNOWN, а token() - пустую лексему.
+class TokenCursor {
+protected:
+    static const Token& endToken() {
+        static const Token end(TokenTypes::UNKNOWN, "", -1, -1);
+        return end;
+    }
+
+public:
+    virtual ~TokenCursor() = default;
+
+    virtual TokenTypes type(int ahead) const = 0;
+    virtual const Token& token() const = 0;
+    virtual bool atEnd() const = 0;
+    virtual void advance() = 0;
+};
+
+// Готовый массив лексем
+class VectorTokenCursor : public TokenCursor {
+private:
+    vector<Token> tokens;
+    size_t pos = 0;
+
+public:
+    explicit VectorTokenCursor(vector<Token> tkns) : tokens(move(tkns)) {}
+
+    TokenTypes type(int ahead) const override {
+        return pos + ahead < tokens.size() ? tokens[pos + ahead].type : TokenTypes::UNKNOWN;
+    }
+
+    const Token& token() const override {
+        return pos < tokens.size() ? tokens[pos] : endToken();
+    }
+
+    bool atEnd() const override {
+        return pos >= tokens.size();
+    }
+
+    void advance() override {
+        if (pos < tokens.size()) {
+            pos++;
+        }
+    }
+};
+
+// Параллельные массивы TokenBuffer: peekType/match смотрят только на
+// массив типов, а Token собирается, лишь когда парсеру нужен текст лексемы
+class BufferTokenCursor : public TokenCursor {
+private:
+    TokenBuffer tokens;
+    size_t pos = 0;
+    mutable optional<Token> current;
+
+public:
+    explicit BufferTokenCursor(TokenBuffer tkns) : tokens(move(tkns)) {}
+
+    TokenTypes type(int ahead) const override {
+        return pos + ahead < tokens.size() ? tokens.type(pos + ahead) : TokenTypes::UNKNOWN;
+    }
+
+    const Token& token() const override {
+        if (pos >= tokens.size()) {
+            return endToken();
+        }
+        if (!current.has_value()) {
+            current = tokens.token(pos);
+        }
+        return *current;
+    }
+
+    bool atEnd() const override {
+        return pos >= tokens.size();
+    }
+
+    void advance() override {
+        if (pos < tokens.size()) {
+            pos++;
+            current.reset();
+        }
+    }
+};
+
+// Лексер в потоковом режиме: в памяти держатся только две лексемы
+class StreamTokenCursor : public TokenCursor {
+private:
+    Lexer& lexer;
+    optional<Token> window[2];
+
+public:
+    explicit StreamTokenCursor(Lexer& lx) : lexer(lx) {
+        window[0] = lexer.next();
+        if (window[0].has_value()) {
+            window[1] = lexer.next();
+        }
+    }
+
+    TokenTypes type(int ahead) const override {
+        return window[ahead].has_value() ? window[ahead]->type : TokenTypes::UNKNOWN;
+    }
+
+    const Token& token() const override {
+        return window[0].has_value() ? *window[0] : endToken();
+    }
+
+    bool atEnd() const override {
+        return !window[0].has_value();
+    }
+
+    void advance() override {
+        if (!window[0].has_value()) {
+            return;
+        }
+        window[0] = move(window[1]);
+        window[1] = window[0].has_value() ? lexer.next() : nullopt;
+    }
+};
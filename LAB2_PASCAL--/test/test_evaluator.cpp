@@ -1,5 +1,8 @@
 #include "pch.h"
 #include "../ExpressionEvaluator/Evaluator.h"
+#include "../Lexer/Lexer.h"
+#include "../Parser/Parser.h"
+#include "../Interpreter/Resolver.h"
 
 //NUMERIC_PART
 
@@ -546,4 +549,58 @@ TEST(STRING_EvaluatorTest, no_operations_variable)
     unordered_map<string, variant<int, double, string>> variables = { {"greeting", "Hello"} };
     unordered_map<string, variant<int, double, string>> constants = {};
     EXPECT_EQ(Evaluator::evaluate_string(expression, variables, constants), "Hello");
-}
\ No newline at end of file
+}
+
+//CONTEXT_PART
+
+TEST(CONTEXT_EvaluatorTest, operands_are_read_by_slot) 
+{
+    Lexer lexer("program P; var s, t : string; a : integer; b : double; begin Write(a * 2 + b, s + t); end.");
+    Parser parser(lexer);
+    Program program = parser.parseProgram();
+    Resolver::resolve(program);
+    const auto write = static_cast<const WriteStatement*>(program.body[0]);
+
+    VariableStorage storage;
+    storage.reset(program.variables);
+    ASSERT_EQ(storage.integers.size(), 1);
+    ASSERT_EQ(storage.reals.size(), 1);
+    ASSERT_EQ(storage.texts.size(), 2);
+    storage.texts = { "ab", "cd" };
+    storage.integers[0] = 3;
+    storage.reals[0] = 0.5;
+    EvaluationContext context(storage);
+    EXPECT_EQ(context.integer(0), 3);
+    EXPECT_EQ(context.text(1), "cd");
+    const CompiledExpression* number = ExpressionCompiler::compile(program.arena, write->arguments[0]);
+    vector<double> stack(number->depth);
+    EXPECT_EQ(Evaluator::evaluateNumber(*number, context, stack.data()), 6.5);
+    string text;
+    Evaluator::appendString(*ExpressionCompiler::compile(program.arena, write->arguments[1]), context, text);
+    EXPECT_EQ(text, "abcd");
+
+    storage.integers[0] = 10; // контекст видит изменения ячеек
+    EXPECT_EQ(Evaluator::evaluateNumber(*number, context, stack.data()), 20.5);
+}
+
+TEST(CONTEXT_EvaluatorTest, compiled_expression_keeps_precedence) 
+{
+    Lexer lexer("program P; const K : double = 2.5; var a : integer; b : double; "
+        "begin b := -a * (b - K) / 4 + a div 3 - -b mod 2; b := a - b - K * -(a + 1); end.");
+    Parser parser(lexer);
+    Program program = parser.parseProgram();
+    Resolver::resolve(program);
+
+    VariableStorage storage;
+    storage.integers = { 7 };
+    storage.reals = { 1.25 };
+    EvaluationContext context(storage);
+    const double expected[] = { 7 * 1.25 / 4 + 2 + 1.25, 7 - 1.25 + 2.5 * 8 };
+    for (size_t i = 0; i < program.body.size(); i++)
+    {
+        Expr* value = static_cast<AssignStatement*>(program.body[i])->value;
+        CompiledExpression* compiled = ExpressionCompiler::compile(program.arena, value);
+        vector<double> stack(compiled->depth);
+        EXPECT_EQ(Evaluator::evaluateNumber(*compiled, context, stack.data()), expected[i]);
+    }
+}
@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "../ExpressionEvaluator/Expression.h"
+#include "../Lexer/Lexer.h"
 
 TEST(ExpressionTest, can_create_expression) 
 {
@@ -384,4 +385,56 @@ TEST(ExpressionTest, complex_expression_with_variables_and_parentheses)
         {"b", 3}
     };
     EXPECT_EQ(tmp.Calculate(values), 16);
-}
\ No newline at end of file
+}
+
+TEST(ExpressionTest, single_pass_compiler_matches_validate_convert_compile) 
+{
+    const string sources[] = {
+        "a + b * 2",
+        "-a * -(b - 3) div 2 mod 5",
+        "((1 + 2) * (3 - -4)) / a - b",
+        "a - b - c + d * e / f",
+        "- - 7 + a"
+    };
+    for (const string& source : sources)
+    {
+        vector<Token> infix = Lexer(source).tokenize();
+        CompiledPostfix fused = InfixCompiler::Compile(infix);
+        CompiledPostfix separate = PostfixCalculator::Compile(PostfixConverter::Convert(infix));
+        EXPECT_EQ(fused.code, separate.code) << source;
+        EXPECT_EQ(fused.depth, separate.depth) << source;
+        EXPECT_EQ(fused.operands, separate.operands) << source;
+        EXPECT_EQ(fused.error, "") << source;
+    }
+}
+
+TEST(ExpressionTest, single_pass_compiler_reports_errors_like_separate_passes) 
+{
+    EXPECT_THROW(InfixCompiler::Compile(Lexer("(a + 1").tokenize()), runtime_error);
+    EXPECT_THROW(InfixCompiler::Compile(Lexer("a + 1)").tokenize()), runtime_error);
+    EXPECT_THROW(InfixCompiler::Compile(Lexer("a + \"s\"").tokenize()), runtime_error);
+    // ошибка арности не мешает найти ошибку скобок дальше
+    EXPECT_THROW(InfixCompiler::Compile(Lexer("a + * 2)").tokenize()), runtime_error);
+
+    EXPECT_EQ(InfixCompiler::Compile(Lexer("a +").tokenize()).error, "Invalid postfix expression: insufficient operands for operator +");
+    EXPECT_EQ(InfixCompiler::Compile(Lexer("- a mod").tokenize()).error, "Invalid postfix expression: insufficient operands for operator mod");
+    EXPECT_EQ(InfixCompiler::Compile(Lexer("a b").tokenize()).error, "Invalid postfix expression: too many operands or too few operators");
+    EXPECT_EQ(InfixCompiler::Compile({}).error, "Invalid postfix expression: too many operands or too few operators");
+}
+
+TEST(ExpressionTest, long_expression_compiles_in_one_pass) 
+{
+    vector<Token> infix;
+    infix.reserve(10001);
+    infix.push_back({ TokenTypes::IDENTIFIER, "x" });
+    for (int i = 0; i < 5000; i++)
+    {
+        infix.push_back({ i % 2 ? TokenTypes::MINUS : TokenTypes::PLUS, i % 2 ? "-" : "+" });
+        infix.push_back({ TokenTypes::INTEGER_LITERAL, "1" });
+    }
+    CompiledPostfix compiled = InfixCompiler::Compile(infix);
+    EXPECT_EQ(compiled.depth, 2);
+    EXPECT_EQ(compiled.operands.size(), 1);
+    double x = 3;
+    EXPECT_EQ(PostfixCalculator::Run(compiled, &x), 3);
+}
@@ -29,7 +29,21 @@ void simulateCin(const string& input, function<void()> func) {
     cin.rdbuf(oldCin);
 }
 
-TEST(InterpreterTest, declare_and_use_constants) {
+// программы ниже исполняются каждым способом и должны вести себя одинаково
+class InterpreterEngineTest : public ::testing::TestWithParam<ExecutionEngine> {};
+
+string engineName(const ::testing::TestParamInfo<ExecutionEngine>& info) {
+    switch (info.param) {
+    case ExecutionEngine::TREE: return "Tree";
+    case ExecutionEngine::BYTECODE: return "Bytecode";
+    default: return "Closures";
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(Engines, InterpreterEngineTest,
+    ::testing::Values(ExecutionEngine::TREE, ExecutionEngine::BYTECODE, ExecutionEngine::CLOSURES), engineName);
+
+TEST_P(InterpreterEngineTest, declare_and_use_constants) {
     auto ast = parseCode(R"(program TestConst; 
                                         const 
                                             PI : double = 3.14; 
@@ -38,20 +52,22 @@ TEST(InterpreterTest, declare_and_use_constants) {
                                         begin 
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     EXPECT_NO_THROW(interpreter.run());
 }
 
-TEST(InterpreterTest, redeclare_constant_throws_error) {
+TEST_P(InterpreterEngineTest, redeclare_constant_throws_error) {
     auto ast = parseCode(R"(program TestConstRedecl; 
                                         const 
                                             PI : double = 3.14; 
                                             PI : integer = 10; 
                                         begin end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     EXPECT_THROW(interpreter.run(), runtime_error);
 }
 
-TEST(InterpreterTest, declare_variables) {
+TEST_P(InterpreterEngineTest, declare_variables) {
     auto ast = parseCode(R"(program TestVar; 
                                         var 
                                             x, y : integer; 
@@ -60,10 +76,11 @@ TEST(InterpreterTest, declare_variables) {
                                         begin 
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     EXPECT_NO_THROW(interpreter.run());
 }
 
-TEST(InterpreterTest, redeclare_variable_throws_error) {
+TEST_P(InterpreterEngineTest, redeclare_variable_throws_error) {
     auto ast = parseCode(R"(program TestVarRedecl; 
                                         var 
                                             x : integer;    
@@ -71,10 +88,11 @@ TEST(InterpreterTest, redeclare_variable_throws_error) {
                                         begin 
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     EXPECT_THROW(interpreter.run(), runtime_error);
 }
 
-TEST(InterpreterTest, declare_variable_same_name_as_constant_throws_error) {
+TEST_P(InterpreterEngineTest, declare_variable_same_name_as_constant_throws_error) {
     auto ast = parseCode(R"(program TestVarConstConflict; 
                                         const 
                                             VALUE : integer = 5; 
@@ -83,10 +101,11 @@ TEST(InterpreterTest, declare_variable_same_name_as_constant_throws_error) {
                                         begin 
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     EXPECT_THROW(interpreter.run(), runtime_error);
 }
 
-TEST(InterpreterTest, assign_literal_to_variable) {
+TEST_P(InterpreterEngineTest, assign_literal_to_variable) {
     auto ast = parseCode(R"(program TestAssignLit; 
                                         var 
                                             count : integer; 
@@ -98,10 +117,11 @@ TEST(InterpreterTest, assign_literal_to_variable) {
                                              
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     EXPECT_NO_THROW(interpreter.run());
 }
 
-TEST(InterpreterTest, assign_variable_to_variable) {
+TEST_P(InterpreterEngineTest, assign_variable_to_variable) {
     auto ast = parseCode(R"(program TestAssignVar; 
                                         var 
                                             a : integer; 
@@ -111,10 +131,11 @@ TEST(InterpreterTest, assign_variable_to_variable) {
                                             b := a; 
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     EXPECT_NO_THROW(interpreter.run());
 }
 
-TEST(InterpreterTest, assign_to_constant_throws_error) {
+TEST_P(InterpreterEngineTest, assign_to_constant_throws_error) {
     auto ast = parseCode(R"(program TestAssignConstError;
                                         const
                                             VALUE : integer = 5;
@@ -122,49 +143,54 @@ TEST(InterpreterTest, assign_to_constant_throws_error) {
                                             VALUE := 10;
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     EXPECT_THROW(interpreter.run(), runtime_error);
 }
 
-TEST(InterpreterTest, assign_to_undeclared_variable_throws_error) {
+TEST_P(InterpreterEngineTest, assign_to_undeclared_variable_throws_error) {
     auto ast = parseCode(R"(program TestAssignUndeclaredError;
                                         begin
                                             x := 5;
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     EXPECT_THROW(interpreter.run(), runtime_error);
 }
 
-TEST(InterpreterTest, write_string_literal) {
+TEST_P(InterpreterEngineTest, write_string_literal) {
     auto ast = parseCode(R"(program TestWriteStr;
                                         begin
                                             Write("Hello World");
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     stringstream ss = captureCout([&]() { interpreter.run(); });
     EXPECT_EQ(ss.str(), "Hello World\n");
 }
 
-TEST(InterpreterTest, write_integer_literal) {
+TEST_P(InterpreterEngineTest, write_integer_literal) {
     auto ast = parseCode(R"(program TestWriteInt;
                                         begin
                                             Write(123);
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     stringstream ss = captureCout([&]() { interpreter.run(); });
     EXPECT_EQ(ss.str(), "123\n");
 }
 
-TEST(InterpreterTest, write_double_literal) {
+TEST_P(InterpreterEngineTest, write_double_literal) {
     auto ast = parseCode(R"(program TestWriteDouble;
                                         begin
                                             Write(3.14159);
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     stringstream ss = captureCout([&]() { interpreter.run(); });
     EXPECT_EQ(ss.str(), "3.14159\n");
 }
 
-TEST(InterpreterTest, write_variable) {
+TEST_P(InterpreterEngineTest, write_variable) {
     auto ast = parseCode(R"(program TestWriteVar;
                                         var
                                             msg : string;
@@ -173,11 +199,12 @@ TEST(InterpreterTest, write_variable) {
                                             Write(msg);
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     stringstream ss = captureCout([&]() { interpreter.run(); });
     EXPECT_EQ(ss.str(), "Goodbye\n");
 }
 
-TEST(InterpreterTest, write_multiple_arguments) {
+TEST_P(InterpreterEngineTest, write_multiple_arguments) {
     auto ast = parseCode(R"(program TestWriteMulti;
                                         var
                                             num : integer;
@@ -188,20 +215,22 @@ TEST(InterpreterTest, write_multiple_arguments) {
                                             Write("Answer: ", num, " PI: ", pi);
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     stringstream ss = captureCout([&]() { interpreter.run(); });
     EXPECT_EQ(ss.str(), "Answer: 42 PI: 3.14\n");
 }
 
-TEST(InterpreterTest, write_undeclared_variable_in_expression_throws_error) {
+TEST_P(InterpreterEngineTest, write_undeclared_variable_in_expression_throws_error) {
     auto ast = parseCode(R"(program TestWriteUndeclaredVarError;
                                         begin
                                             Write(unknown);
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     EXPECT_THROW(interpreter.run(), runtime_error);
 }
 
-TEST(InterpreterTest, read_integer_variable) {
+TEST_P(InterpreterEngineTest, read_integer_variable) {
     auto ast = parseCode(R"(program TestReadInt;
                                         var
                                             num : integer;
@@ -210,13 +239,14 @@ TEST(InterpreterTest, read_integer_variable) {
                                             Write("You entered: ", num);
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     simulateCin("123\n", [&]() {
         stringstream ss = captureCout([&]() { interpreter.run(); });
         EXPECT_EQ(ss.str(), "You entered: 123\n");
         });
 }
 
-TEST(InterpreterTest, read_double_variable) {
+TEST_P(InterpreterEngineTest, read_double_variable) {
     auto ast = parseCode(R"(program TestReadDouble;
                                         var
                                             pi : double;
@@ -225,13 +255,14 @@ TEST(InterpreterTest, read_double_variable) {
                                             Write("You entered: ", pi);
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     simulateCin("3.14\n", [&]() {
         stringstream ss = captureCout([&]() { interpreter.run(); });
         EXPECT_EQ(ss.str(), "You entered: 3.14\n");
         });
 }
 
-TEST(InterpreterTest, read_string_variable) {
+TEST_P(InterpreterEngineTest, read_string_variable) {
     auto ast = parseCode(R"(program TestReadString;
                                         var
                                             msg : string;
@@ -240,13 +271,14 @@ TEST(InterpreterTest, read_string_variable) {
                                             Write("You entered: ", msg);
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     simulateCin("Hello World\n", [&]() {
         stringstream ss = captureCout([&]() { interpreter.run(); });
         EXPECT_EQ(ss.str(), "You entered: Hello World\n");
         });
 }
 
-TEST(InterpreterTest, read_multiple_variables) {
+TEST_P(InterpreterEngineTest, read_multiple_variables) {
     auto ast = parseCode(R"(program TestReadMulti;
                                         var
                                             a : integer;
@@ -257,13 +289,14 @@ TEST(InterpreterTest, read_multiple_variables) {
                                             Write("Entered: ", a, " ", b, " ", c);
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     simulateCin("10\n2.71\nTest\n", [&]() {
         stringstream ss = captureCout([&]() { interpreter.run(); });
         EXPECT_EQ(ss.str(), "Entered: 10 2.71 Test\n");
         });
 }
 
-TEST(InterpreterTest, read_to_constant_throws_error) {
+TEST_P(InterpreterEngineTest, read_to_constant_throws_error) {
     auto ast = parseCode(R"(program TestReadConstError;
                                         const
                                             VALUE : integer = 5;
@@ -271,23 +304,25 @@ TEST(InterpreterTest, read_to_constant_throws_error) {
                                             Read(VALUE);
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     simulateCin("10\n", [&]() {
         EXPECT_THROW(interpreter.run(), runtime_error);
         });
 }
 
-TEST(InterpreterTest, read_undeclared_variable_throws_error) {
+TEST_P(InterpreterEngineTest, read_undeclared_variable_throws_error) {
     auto ast = parseCode(R"(program TestReadUndeclaredError;
                                         begin
                                             Read(unknown);
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     simulateCin("test\n", [&]() {
         EXPECT_THROW(interpreter.run(), runtime_error);
         });
 }
 
-TEST(InterpreterTest, read_invalid_integer_input_throws_error) {
+TEST_P(InterpreterEngineTest, read_invalid_integer_input_throws_error) {
     auto ast = parseCode(R"(program TestReadInvalidIntError;
                                         var
                                             num : integer;
@@ -295,12 +330,13 @@ TEST(InterpreterTest, read_invalid_integer_input_throws_error) {
                                             Read(num);
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     simulateCin("abc\n", [&]() {
         EXPECT_THROW(interpreter.run(), runtime_error);
         });
 }
 
-TEST(InterpreterTest, if_statement_numeric_true) {
+TEST_P(InterpreterEngineTest, if_statement_numeric_true) {
     auto ast = parseCode(R"(program TestIfTrue;
                                         var
                                             x : integer;
@@ -310,11 +346,12 @@ TEST(InterpreterTest, if_statement_numeric_true) {
                                                 Write("Positive");
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     stringstream ss = captureCout([&]() { interpreter.run(); });
     EXPECT_EQ(ss.str(), "Positive\n");
 }
 
-TEST(InterpreterTest, if_statement_numeric_false_no_else) {
+TEST_P(InterpreterEngineTest, if_statement_numeric_false_no_else) {
     auto ast = parseCode(R"(program TestIfFalseNoElse;
                                         var
                                             x : integer;
@@ -324,11 +361,12 @@ TEST(InterpreterTest, if_statement_numeric_false_no_else) {
                                                 Write("Positive");
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     stringstream ss = captureCout([&]() { interpreter.run(); });
     EXPECT_EQ(ss.str().find("Positive"), string::npos);
 }
 
-TEST(InterpreterTest, if_statement_numeric_false_with_else) {
+TEST_P(InterpreterEngineTest, if_statement_numeric_false_with_else) {
     auto ast = parseCode(R"(program TestIfFalseElse;
                                         var
                                             x : integer;
@@ -340,11 +378,12 @@ TEST(InterpreterTest, if_statement_numeric_false_with_else) {
                                                 Write("Not positive");
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     stringstream ss = captureCout([&]() { interpreter.run(); });
     EXPECT_EQ(ss.str(), "Not positive\n");
 }
 
-TEST(InterpreterTest, if_statement_string_equal_true) {
+TEST_P(InterpreterEngineTest, if_statement_string_equal_true) {
     auto ast = parseCode(R"(program TestIfStrTrue;
                                         var
                                             msg : string;
@@ -354,11 +393,12 @@ TEST(InterpreterTest, if_statement_string_equal_true) {
                                                 Write("Affirmative");
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     stringstream ss = captureCout([&]() { interpreter.run(); });
     EXPECT_EQ(ss.str(), "Affirmative\n");
 }
 
-TEST(InterpreterTest, if_statement_string_equal_false_with_else) {
+TEST_P(InterpreterEngineTest, if_statement_string_equal_false_with_else) {
     auto ast = parseCode(R"(program TestIfStrFalseElse;
                                         var
                                             msg : string;
@@ -370,11 +410,12 @@ TEST(InterpreterTest, if_statement_string_equal_false_with_else) {
                                                 Write("Negative");
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     stringstream ss = captureCout([&]() { interpreter.run(); });
     EXPECT_EQ(ss.str(), "Negative\n");
 }
 
-TEST(InterpreterTest, if_statement_missing_comparison_operator_throws_error) {
+TEST_P(InterpreterEngineTest, if_statement_missing_comparison_operator_throws_error) {
     auto ast = parseCode(R"(program TestIfNoOpError;
                                         var
                                             x : integer;
@@ -384,10 +425,11 @@ TEST(InterpreterTest, if_statement_missing_comparison_operator_throws_error) {
                                                 Write("Error");
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     EXPECT_THROW(interpreter.run(), runtime_error);
 }
 
-TEST(InterpreterTest, if_statement_type_mismatch_throws_error) {
+TEST_P(InterpreterEngineTest, if_statement_type_mismatch_throws_error) {
     auto ast = parseCode(R"(program TestIfTypeError; 
                                         var 
                                             num : integer; 
@@ -398,32 +440,360 @@ TEST(InterpreterTest, if_statement_type_mismatch_throws_error) {
                                                 Write("Error"); 
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     EXPECT_THROW(interpreter.run(), runtime_error);
 }
 
-TEST(InterpreterTest, write_starts_with_comma_throws_error) {
+TEST_P(InterpreterEngineTest, write_starts_with_comma_throws_error) {
     auto ast = parseCode(R"(program ErrorWriteCommaStartError;
                                         begin
                                             Write(, "Error");
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     EXPECT_THROW(interpreter.run(), runtime_error);
 }
 
-TEST(InterpreterTest, write_consecutive_commas_throws_error) {
+TEST_P(InterpreterEngineTest, write_consecutive_commas_throws_error) {
     auto ast = parseCode(R"(program ErrorWriteConsecutiveCommasError;
                                       begin
                                         Write("A", , "B");
                                       end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
     EXPECT_THROW(interpreter.run(), runtime_error);
 }
 
-TEST(InterpreterTest, write_ends_with_comma_throws_error) {
+TEST_P(InterpreterEngineTest, write_ends_with_comma_throws_error) {
     auto ast = parseCode(R"(program ErrorWriteCommaEndError;
                                         begin
                                             Write("End", );
                                         end.)");
     Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
+    EXPECT_THROW(interpreter.run(), runtime_error);
+}
+
+Program parseProgramCode(const string& code) {
+    Lexer lexer(code);
+    Parser parser(lexer.tokenize());
+    return parser.parseProgram();
+}
+
+TEST_P(InterpreterEngineTest, expression_trees_keep_precedence_and_semantics) {
+    Interpreter interpreter(parseProgramCode(R"(program Trees;
+                                        const
+                                            Greeting : string = "Hi";
+                                        var
+                                            a : integer;
+                                            d : double;
+                                            s : string;
+                                        begin
+                                            a := 7 - 2 * 3 - -1;
+                                            d := (a + 1) * -(1.5 - 3) / 2;
+                                            a := 17 div 5 + 17 mod 5 + 7.9;
+                                            s := Greeting + ", " + "there";
+                                            Write(a, " ", d, " ", s);
+                                            if (s <> "Hi") then Write(-a);
+                                        end.)"));
+    interpreter.setEngine(GetParam());
+    stringstream output = captureCout([&]() { interpreter.run(); });
+    EXPECT_EQ(output.str(), "12 2.25 Hi, there\n-12\n");
+}
+
+TEST_P(InterpreterEngineTest, malformed_expression_throws_when_executed) {
+    Interpreter interpreter(parseProgramCode(R"(program Deferred;
+                                        var
+                                            a : integer;
+                                        begin
+                                            a := 1;
+                                            a := (1 + 2;
+                                        end.)"));
+    interpreter.setEngine(GetParam());
+    EXPECT_THROW(interpreter.run(), runtime_error);
+}
+
+TEST_P(InterpreterEngineTest, resolver_rejects_errors_before_running) {
+    auto ast = parseCode(R"(program ResolveFirst;
+                                        var
+                                            a : integer;
+                                        begin
+                                            Write("started");
+                                            if (a = 0) then
+                                                a := 1;
+                                            else
+                                                a := missing;
+                                        end.)");
+    Interpreter interpreter(ast);
+    interpreter.setEngine(GetParam());
+    bool thrown = false;
+    stringstream output = captureCout([&]() {
+        try { interpreter.run(); }
+        catch (const runtime_error&) { thrown = true; }
+    });
+    EXPECT_TRUE(thrown);
+    EXPECT_EQ(output.str(), "");
     EXPECT_THROW(interpreter.run(), runtime_error);
 }
+
+TEST_P(InterpreterEngineTest, repeated_runs_start_from_fresh_variables) {
+    Interpreter interpreter(parseProgramCode(R"(program Rerun;
+                                        const
+                                            Step : integer = 5;
+                                        var
+                                            total : integer;
+                                            name : string;
+                                        begin
+                                            total := total + Step;
+                                            name := name + "x";
+                                            Write(total, name);
+                                        end.)"));
+    interpreter.setEngine(GetParam());
+    stringstream first = captureCout([&]() { interpreter.run(); });
+    stringstream second = captureCout([&]() { interpreter.run(); });
+    EXPECT_EQ(first.str(), "5x\n");
+    EXPECT_EQ(second.str(), "5x\n");
+    EXPECT_EQ(get<int>(interpreter.valueOf("total")), 5);
+    EXPECT_EQ(get<string>(interpreter.valueOf("name")), "x");
+    EXPECT_EQ(get<int>(interpreter.valueOf("Step")), 5);
+    EXPECT_THROW(interpreter.valueOf("unknown"), runtime_error);
+}
+
+TEST_P(InterpreterEngineTest, type_errors_are_found_before_running) {
+    const string programs[] = {
+        "program T; var a : integer; s : string; begin Write(\"started\"); if (a = 1) then s := s - \"x\"; end.",
+        "program T; var a : integer; s : string; begin Write(\"started\"); if (a = 1) then a := s; end.",
+        "program T; var a : integer; s : string; begin Write(\"started\"); if (a = 1) then Write(s + a); end.",
+        "program T; var a : integer; s : string; begin Write(\"started\"); if (a = 1) then if (s < \"b\") then a := 1; end.",
+        "program T; var a : integer; s : string; begin Write(\"started\"); if (a = 1) then Write(-s); end.",
+    };
+    for (const string& code : programs) {
+        Interpreter interpreter(parseProgramCode(code));
+        interpreter.setEngine(GetParam());
+        bool thrown = false;
+        stringstream output = captureCout([&]() {
+            try { interpreter.run(); }
+            catch (const runtime_error&) { thrown = true; }
+        });
+        EXPECT_TRUE(thrown) << code;
+        EXPECT_EQ(output.str(), "") << code;
+    }
+}
+
+TEST_P(InterpreterEngineTest, string_expressions_are_evaluated_by_type) {
+    Interpreter interpreter(parseProgramCode(R"(program Strings;
+                                        const
+                                            Sep : string = ", ";
+                                        var
+                                            s : string;
+                                            n : integer;
+                                        begin
+                                            s := "a";
+                                            s := s + Sep + s;
+                                            n := 7 div 2;
+                                            if (s + "!" = "a, a!") then
+                                                Write(s + "!", n, Sep, 7 / 2);
+                                        end.)"));
+    interpreter.setEngine(GetParam());
+    stringstream output = captureCout([&]() { interpreter.run(); });
+    EXPECT_EQ(output.str(), "a, a!3, 3.5\n");
+}
+
+TEST(InterpreterTest, compiled_expressions_are_built_once_and_reused) {
+    Interpreter interpreter(parseProgramCode(R"(program Cached;
+                                        var
+                                            a : integer;
+                                            s : string;
+                                        begin
+                                            a := a + 2 * 3;
+                                            s := s + "x";
+                                            if (a > 5) then
+                                                Write(a, s);
+                                        end.)"));
+    const Program& program = interpreter.getProgram();
+    const auto assign = static_cast<const AssignStatement*>(program.body[0]);
+    const auto ifStatement = static_cast<const IfStatement*>(program.body[2]);
+    EXPECT_EQ(assign->value->compiled, nullptr);
+
+    stringstream first = captureCout([&]() { interpreter.run(); });
+    const CompiledExpression* compiled = assign->value->compiled;
+    ASSERT_NE(compiled, nullptr);
+    EXPECT_EQ(compiled->code.size(), 5 + 9 + 9 + 1 + 1 + 1); // a 2 3 * + RETURN
+    EXPECT_EQ(compiled->depth, 3);
+    const auto write = static_cast<const WriteStatement*>(ifStatement->thenBranch[0]);
+    ASSERT_NE(write->arguments[1]->compiled, nullptr);
+    EXPECT_EQ(write->arguments[1]->compiled->type, ValueType::STRING);
+    EXPECT_EQ(write->arguments[1]->compiled->parts.size(), 1);
+
+    stringstream second = captureCout([&]() { interpreter.run(); });
+    EXPECT_EQ(assign->value->compiled, compiled);
+    EXPECT_EQ(first.str(), "6x\n");
+    EXPECT_EQ(second.str(), "6x\n");
+}
+
+// вывод, ошибка и переменные после run() на заданном способе исполнения
+struct EngineResult {
+    string output;
+    string error;
+    vector<variant<int, double, string>> values;
+};
+
+EngineResult runWithEngine(const string& code, ExecutionEngine engine, const string& input, const vector<string>& names) {
+    Interpreter interpreter(parseProgramCode(code));
+    interpreter.setEngine(engine);
+    EngineResult result;
+    simulateCin(input, [&]() {
+        result.output = captureCout([&]() {
+            try { interpreter.run(); }
+            catch (const exception& e) { result.error = e.what(); }
+        }).str();
+    });
+    if (result.error.empty()) {
+        for (const string& name : names)
+            result.values.push_back(interpreter.valueOf(name));
+    }
+    return result;
+}
+
+TEST(InterpreterTest, bytecode_engine_matches_tree_walker) {
+    const string declarations = R"(program Engines;
+                                        const
+                                            Limit : integer = 10;
+                                            Greeting : string = "Hi";
+                                        var
+                                            a, b : integer;
+                                            x : double;
+                                            s, t : string;
+                                        begin
+                                            )";
+    const string bodies[] = {
+        "a := 7; b := a div 2 * -3 + a mod 4; x := a / 4 - b; Write(a, \" \", b, \" \", x);",
+        "s := Greeting + \", \"; s := s + s; t := s + \"!\"; Write(t, s, Greeting);",
+        "Read(a, x, s); if (a * 2 > Limit) then begin Write(\"big \", a); b := 1; end else Write(\"small\"); Write(s, x);",
+        "if (a = 0) then if (s = \"\") then Write(\"both\"); else Write(\"no\"); Write(\"after\");",
+        "a := 3; if (s <> Greeting) then begin if (a >= 3) then begin Write(\"ge\"); end if (a <= 2) then Write(\"le\"); end",
+        "a := 5; Write(a); b := a div (a - 5); Write(\"unreachable\");",
+        "x := 1.5; Write(\"x\"); if (a / 0 < x) then Write(\"no\");",
+        "Write(1, 2 mod 0);",
+        "Read(a);",
+    };
+    for (const string& body : bodies) {
+        string code = declarations + body + "\nend.";
+        EngineResult tree = runWithEngine(code, ExecutionEngine::TREE, "7\n2.5\nabc\n", { "a", "b", "x", "s", "t" });
+        EngineResult bytecode = runWithEngine(code, ExecutionEngine::BYTECODE, "7\n2.5\nabc\n", { "a", "b", "x", "s", "t" });
+        EXPECT_EQ(tree.output, bytecode.output) << body;
+        EXPECT_EQ(tree.error, bytecode.error) << body;
+        EXPECT_EQ(tree.values, bytecode.values) << body;
+        EngineResult closures = runWithEngine(code, ExecutionEngine::CLOSURES, "7\n2.5\nabc\n", { "a", "b", "x", "s", "t" });
+        EXPECT_EQ(tree.output, closures.output) << body;
+        EXPECT_EQ(tree.error, closures.error) << body;
+        EXPECT_EQ(tree.values, closures.values) << body;
+    }
+}
+
+TEST(InterpreterTest, bytecode_engine_runs_repeatedly) {
+    Interpreter interpreter(parseProgramCode(R"(program Rerun;
+                                        var
+                                            total : integer;
+                                            name : string;
+                                        begin
+                                            total := total + 5;
+                                            name := name + "x";
+                                            Write(total, name);
+                                        end.)"));
+    interpreter.setEngine(ExecutionEngine::BYTECODE);
+    EXPECT_EQ(interpreter.getEngine(), ExecutionEngine::BYTECODE);
+    stringstream first = captureCout([&]() { interpreter.run(); });
+    stringstream second = captureCout([&]() { interpreter.run(); });
+    EXPECT_EQ(first.str(), "5x\n");
+    EXPECT_EQ(second.str(), "5x\n");
+    EXPECT_EQ(get<string>(interpreter.valueOf("name")), "x");
+}
+
+TEST(InterpreterTest, closure_engine_runs_repeatedly) {
+    Interpreter interpreter(parseProgramCode(R"(program Rerun;
+                                        var
+                                            total : integer;
+                                            ratio : double;
+                                            name : string;
+                                        begin
+                                            total := total + 5;
+                                            ratio := total / 2;
+                                            name := name + "x";
+                                            if (name = "x") then Write(total, name, ratio);
+                                        end.)"));
+    interpreter.setEngine(ExecutionEngine::CLOSURES);
+    stringstream first = captureCout([&]() { interpreter.run(); });
+    stringstream second = captureCout([&]() { interpreter.run(); });
+    EXPECT_EQ(first.str(), "5x2.5\n");
+    EXPECT_EQ(second.str(), "5x2.5\n");
+    EXPECT_EQ(get<double>(interpreter.valueOf("ratio")), 2.5);
+}
+
+TEST(InterpreterTest, variables_get_slots_in_arrays_of_their_type) {
+    Interpreter interpreter(parseProgramCode(R"(program Slots;
+                                        const
+                                            Step : integer = 4;
+                                        var
+                                            a : integer;
+                                            s : string;
+                                            b : integer;
+                                            x : double;
+                                            t : string;
+                                        begin
+                                            b := Step * 2;
+                                            x := b / Step;
+                                            t := "t";
+                                            s := t + t;
+                                            a := b + Step;
+                                        end.)"));
+    interpreter.run();
+    const Span<VariableSlot> variables = interpreter.getProgram().variables;
+    ASSERT_EQ(variables.size(), 5);
+    const uint32_t expectedSlots[] = { 0, 0, 1, 0, 1 };
+    for (size_t i = 0; i < variables.size(); i++)
+        EXPECT_EQ(variables[i].slot, expectedSlots[i]) << variables[i].name;
+    EXPECT_EQ(get<int>(interpreter.valueOf("a")), 12);
+    EXPECT_EQ(get<int>(interpreter.valueOf("b")), 8);
+    EXPECT_EQ(get<double>(interpreter.valueOf("x")), 2.0);
+    EXPECT_EQ(get<string>(interpreter.valueOf("s")), "tt");
+    EXPECT_EQ(get<int>(interpreter.valueOf("Step")), 4);
+}
+
+TEST(InterpreterTest, integer_expressions_are_exact_in_int64) {
+    const string declarations = R"(program Int64;
+                                        var
+                                            a : integer;
+                                            x : double;
+                                        begin
+                                            )";
+    struct Case {
+        string body;
+        string output;
+        string error;
+    };
+    const Case cases[] = {
+        { "Write(3037000499 * 3037000499);", "9223372030926249001\n", "" },
+        { "Write(-7 div 2, \" \", -7 mod 2, \" \", 7 div -2, \" \", 7 mod -2);", "-4 -1 -4 1\n", "" },
+        { "x := 9007199254740993 - 9007199254740992 + 0.5; Write(x);", "1.5\n", "" },
+        { "if (9007199254740993 > 9007199254740992) then Write(\"exact\"); else Write(\"rounded\");", "exact\n", "" },
+        { "a := 2147483647; Write(a + 1, \" \", a * 2 div 4);", "2147483648 1073741823\n", "" },
+        { "a := 2147483647 + 1;", "", "Failed to assign a: Integer overflow" },
+        { "a := -2147483648.9; Write(a); a := 2147483647.9; Write(a);", "-2147483648\n2147483647\n", "" },
+        { "a := 3000000000.0;", "", "Failed to assign a: Integer overflow" },
+        { "x := 5000000000.5; a := x;", "", "Failed to assign a: Integer overflow" },
+        { "x := -2147483649.0; a := x;", "", "Failed to assign a: Integer overflow" },
+        { "Write(9223372036854775807 + 1);", "", "Runtime Error in Write statement: Could not evaluate the expression: Integer overflow" },
+        { "if (-9223372036854775807 - 2 < 0) then Write(\"no\");", "", "Invalid condition expression: Integer overflow" },
+        { "a := 5; Write(a mod 0);", "", "Runtime Error in Write statement: Could not evaluate the expression: Modulo by zero" },
+        { "a := 5; x := a div 0 + 0.5;", "", "Failed to assign x: Integer division by zero" },
+    };
+    for (const Case& test : cases) {
+        string code = declarations + test.body + "\nend.";
+        for (ExecutionEngine engine : { ExecutionEngine::TREE, ExecutionEngine::BYTECODE, ExecutionEngine::CLOSURES }) {
+            EngineResult result = runWithEngine(code, engine, "", {});
+            EXPECT_EQ(result.output, test.output) << test.body << " engine " << int(engine);
+            EXPECT_EQ(result.error, test.error) << test.body << " engine " << int(engine);
+        }
+    }
+}
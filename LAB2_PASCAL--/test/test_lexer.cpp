@@ -1,9 +1,15 @@
 #include "pch.h"
 #include "../Base/Token.h"
 #include "../Lexer/Lexer.h"
+#include "../Lexer/IncrementalLexer.h"
+#include "../Base/SourceBuffer.cpp"
 #include <vector>
 #include <string>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <random>
 
 using namespace std;
 
@@ -199,3 +205,366 @@ TEST(LexerTest, throws_error_for_unknown_token) {
     ASSERT_THROW(lexer.tokenize(), runtime_error);
 }
 
+
+TEST(LexerTest, token_views_match_tokens) {
+    string source = "program p; var x: integer; begin x := 10 div 3; Write(\"res = \", x >= 2.5); end.";
+    Lexer lexer(source);
+    vector<Token> tokens = lexer.tokenize();
+    vector<TokenView> views = lexer.tokenizeViews();
+    ASSERT_EQ(tokens.size(), views.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        EXPECT_TRUE(CompareTokens({ tokens[i] }, { views[i].toToken() }));
+    }
+}
+
+TEST(LexerTest, token_views_point_into_source_buffer) {
+    shared_ptr<const SourceBuffer> buffer;
+    vector<TokenView> views;
+    {
+        Lexer lexer("counter := \"text\";");
+        views = lexer.tokenizeViews();
+        buffer = lexer.source();
+    }
+    string_view text = buffer->text();
+    ASSERT_EQ(views.size(), 4);
+    for (const TokenView& view : views) {
+        EXPECT_GE(view.lexeme.data(), text.data());
+        EXPECT_LE(view.lexeme.data() + view.lexeme.size(), text.data() + text.size());
+    }
+    EXPECT_EQ(views[0].lexeme, "counter");
+    EXPECT_EQ(views[2].lexeme, "text");
+}
+
+TEST(LexerTest, colon_does_not_swallow_next_character) {
+    Lexer lexer("x:integer");
+    vector<Token> expectedTokens = {
+        {TokenTypes::IDENTIFIER, "x", 1, 1},
+        {TokenTypes::COLON, ":", 1, 2},
+        {TokenTypes::KEYWORD_INTEGER, "integer", 1, 3}
+    };
+    EXPECT_TRUE(CompareTokens(expectedTokens, lexer.tokenize()));
+}
+
+TEST(LexerTest, keyword_lookup_is_exact) {
+    for (const Keyword& keyword : keywordList) {
+        EXPECT_EQ(findKeyword(keyword.text), keyword.type);
+    }
+    EXPECT_EQ(findKeyword("Program"), TokenTypes::UNKNOWN);
+    EXPECT_EQ(findKeyword("ends"), TokenTypes::UNKNOWN);
+    EXPECT_EQ(findKeyword("wrte"), TokenTypes::UNKNOWN);
+    EXPECT_EQ(findKeyword("x"), TokenTypes::UNKNOWN);
+    EXPECT_EQ(findKeyword("integers"), TokenTypes::UNKNOWN);
+}
+
+TEST(LexerTest, tracks_lines_across_long_whitespace_runs) {
+    string source = string(40, ' ') + "\n" + string(37, ' ') + "\t\r\n\n" + string(50, ' ') + "x\n  " + string(70, '\n') + "y";
+    Lexer lexer(source);
+    vector<Token> expectedTokens = {
+        {TokenTypes::IDENTIFIER, "x", 4, 51},
+        {TokenTypes::IDENTIFIER, "y", 75, 1}
+    };
+    EXPECT_TRUE(CompareTokens(expectedTokens, lexer.tokenize()));
+}
+
+TEST(LexerTest, can_tokenize_long_identifiers_and_numbers) {
+    string identifier = "a" + string(80, '_') + "Z9";
+    string digits = string(45, '7');
+    string source = identifier + " " + digits + "." + digits + ";" + digits;
+    Lexer lexer(source);
+    vector<Token> expectedTokens = {
+        {TokenTypes::IDENTIFIER, identifier, 1, 1},
+        {TokenTypes::DOUBLE_LITERAL, digits + "." + digits, 1, 85},
+        {TokenTypes::SEMICOLON, ";", 1, 176},
+        {TokenTypes::INTEGER_LITERAL, digits, 1, 177}
+    };
+    EXPECT_TRUE(CompareTokens(expectedTokens, lexer.tokenize()));
+}
+
+TEST(LexerTest, char_scanner_stops_at_first_foreign_character) {
+    string text = string(33, 'q') + "#" + string(20, '5') + "x";
+    EXPECT_EQ(CharScanner::skipIdentifier(text.data(), 0, text.size()), 33);
+    EXPECT_EQ(CharScanner::skipDigits(text.data(), 34, text.size()), 54);
+    EXPECT_EQ(CharScanner::skipIdentifier(text.data(), 34, text.size()), text.size());
+}
+
+TEST(LexerTest, iterator_yields_same_tokens_as_tokenize) {
+    Lexer lexer("program p; begin Write(1 + 2); end.");
+    vector<Token> expectedTokens = lexer.tokenize();
+    vector<Token> streamedTokens;
+    for (const TokenView& token : lexer) {
+        streamedTokens.push_back(token.toToken());
+    }
+    ASSERT_EQ(streamedTokens.size(), expectedTokens.size());
+    for (size_t i = 0; i < expectedTokens.size(); ++i) {
+        EXPECT_EQ(streamedTokens[i].type, expectedTokens[i].type);
+        EXPECT_EQ(streamedTokens[i].value, expectedTokens[i].value);
+        EXPECT_EQ(streamedTokens[i].column, expectedTokens[i].column);
+    }
+}
+
+TEST(LexerTest, file_backed_lexer_matches_string_lexer) {
+    string source = "program Example;\nvar\n    x: integer;\nbegin\n    x := 12 + 3;\n    Write(\"value\", x);\nend.";
+    const string path = "lexer_file_backed_test.pas";
+    {
+        ofstream file(path, ios::binary);
+        file << source;
+    }
+    vector<Token> fileTokens = Lexer::fromFile(path).tokenize();
+    remove(path.c_str());
+    EXPECT_TRUE(CompareTokens(Lexer(source).tokenize(), fileTokens));
+}
+
+TEST(LexerTest, empty_file_and_stream_are_read_into_memory) {
+    const string path = "lexer_empty_file_test.pas";
+    {
+        ofstream file(path, ios::binary);
+    }
+    EXPECT_TRUE(Lexer::fromFile(path).tokenize().empty());
+    remove(path.c_str());
+
+    istringstream input("x := 1;");
+    Lexer lexer(SourceBuffer::fromStream(input));
+    EXPECT_EQ(lexer.tokenize().size(), 4);
+}
+
+TEST(LexerTest, missing_file_throws) {
+    EXPECT_THROW(Lexer::fromFile("no_such_source_file.pas"), runtime_error);
+}
+
+TEST(LexerTest, table_engine_matches_switch_engine) {
+    vector<string> sources = {
+        "program Example;\nconst\n    Pi: double = 3.1415926;\nvar\n    num1, num2: integer;\n    s: string;\nbegin\n"
+        "    num1 := (num2 + 12) * 3 div 2 mod 5 - 1 / 4;\n    s := \"multi\nline\" + \"x\";\n"
+        "    if (num1 <> num2) then Write(s) else Read(num1);\n    if (a <= b) then if (a >= b) then if (a < b) then Write(a > b);\nend.",
+        "x:integer", "a:=b", "1. 2.5 3..4 1.2.3", "end", "end.", "end .", "\t\v\f\r\n  _under_score1 begin", ".", "x <", "y >", "z :",
+        "WriteRead Write Read integerx", ""
+    };
+    for (const string& source : sources) {
+        vector<Token> switchTokens = Lexer(source, LexerEngine::SWITCH).tokenize();
+        vector<Token> tableTokens = Lexer(source, LexerEngine::TABLE).tokenize();
+        EXPECT_TRUE(CompareTokens(switchTokens, tableTokens)) << source;
+    }
+}
+
+TEST(LexerTest, table_engine_reports_same_errors) {
+    vector<string> sources = { "x := 5 # 3;", "Write(\"unterminated);", "s := \"", "a := b @" };
+    for (const string& source : sources) {
+        string switchError, tableError;
+        try { Lexer(source, LexerEngine::SWITCH).tokenize(); }
+        catch (const runtime_error& e) { switchError = e.what(); }
+        try { Lexer(source, LexerEngine::TABLE).tokenize(); }
+        catch (const runtime_error& e) { tableError = e.what(); }
+        EXPECT_FALSE(switchError.empty()) << source;
+        EXPECT_EQ(switchError, tableError) << source;
+    }
+}
+
+string generateLexerProgram(int statements) {
+    string code = "program Generated;\nvar\n    counter, total: integer;\n    text: string;\nbegin\n";
+    for (int i = 0; i < statements; i++) {
+        code += "    counter := (total + " + to_string(i) + ") * 2 div 3 - 1.5;\n";
+        if (i % 7 == 0)
+            code += "    text := \"line one\n    line two " + to_string(i) + "\n\";\n";
+        if (i % 11 == 0)
+            code += "    if (counter <> total) then Write(\"value = \", counter);\n";
+    }
+    code += "end.";
+    return code;
+}
+
+TEST(LexerTest, parallel_tokenize_matches_sequential) {
+    string source = generateLexerProgram(20000);
+    ASSERT_GT(source.size(), 8 * Lexer::parallelMinChunk);
+    for (LexerEngine engine : { LexerEngine::SWITCH, LexerEngine::TABLE }) {
+        Lexer lexer(source, engine);
+        vector<Token> sequential = lexer.tokenize();
+        for (unsigned threads : { 2u, 3u, 8u }) {
+            EXPECT_TRUE(CompareTokens(sequential, lexer.tokenizeParallel(threads))) << threads;
+        }
+    }
+}
+
+TEST(LexerTest, parallel_tokenize_reports_sequential_error) {
+    string source = generateLexerProgram(20000) + "\n x := 1 # 2;";
+    string sequentialError, parallelError;
+    try { Lexer(source).tokenize(); }
+    catch (const runtime_error& e) { sequentialError = e.what(); }
+    try { Lexer(source).tokenizeParallel(4); }
+    catch (const runtime_error& e) { parallelError = e.what(); }
+    EXPECT_FALSE(sequentialError.empty());
+    EXPECT_EQ(sequentialError, parallelError);
+}
+
+TokenRange applyAndCheck(IncrementalLexer& lexer, const TextEdit& edit) {
+    TokenRange range = lexer.apply(edit);
+    EXPECT_TRUE(CompareTokens(Lexer(lexer.source()).tokenize(), lexer.tokens())) << lexer.source();
+    return range;
+}
+
+TEST(LexerTest, incremental_edit_relexes_only_touched_tokens) {
+    IncrementalLexer lexer("begin\n    x := 1;\n    y := x + 2;\n    Write(y);\nend.");
+    TokenRange range = applyAndCheck(lexer, { 15, 1, "125" }); // 1 -> 125
+    EXPECT_EQ(range.first, 3);
+    EXPECT_EQ(range.removed, 1);
+    EXPECT_EQ(range.inserted, 1);
+    EXPECT_EQ(lexer.tokens()[3].value, "125");
+
+    range = applyAndCheck(lexer, { 10, 0, "\n" }); // строка перед x
+    EXPECT_EQ(lexer.tokens().back().line, 6);
+}
+
+TEST(LexerTest, incremental_edit_merges_and_splits_tokens) {
+    IncrementalLexer lexer("x : = a < b; end");
+    applyAndCheck(lexer, { 3, 1, "" });   // ": =" -> ":="
+    applyAndCheck(lexer, { 8, 0, ">" });  // "<" -> "<>"
+    applyAndCheck(lexer, { 1, 0, "yz" }); // "x" -> "xyz"
+    applyAndCheck(lexer, { 1, 1, " " });  // "xyz" -> "x z"
+    applyAndCheck(lexer, { lexer.source().size(), 0, "." }); // "end" -> "end."
+    applyAndCheck(lexer, { 0, lexer.source().size(), "" });
+    EXPECT_TRUE(lexer.tokens().empty());
+}
+
+TEST(LexerTest, incremental_edit_handles_string_quotes) {
+    IncrementalLexer lexer("a := \"one\";\nb := 2;\nc := \"two\nthree\";\nd := 4;");
+    string joined = "\";\nb := 2;\nc := \"";
+    TokenRange range = applyAndCheck(lexer, { 9, joined.size(), "" }); // две строки слились в одну
+    EXPECT_EQ(range.removed, 9);
+    EXPECT_EQ(range.inserted, 1);
+    applyAndCheck(lexer, { 9, 0, joined });
+    EXPECT_EQ(lexer.tokens().back().line, 4);
+    applyAndCheck(lexer, { 29, 1, "" }); // перевод строки внутри строки номера строк не меняет
+}
+
+TEST(LexerTest, incremental_edit_error_keeps_previous_state) {
+    IncrementalLexer lexer("x := 1;");
+    vector<Token> before = lexer.tokens();
+    EXPECT_THROW(lexer.apply({ 5, 0, "#" }), runtime_error);
+    EXPECT_THROW(lexer.apply({ 50, 0, "1" }), out_of_range);
+    EXPECT_EQ(lexer.source(), "x := 1;");
+    EXPECT_TRUE(CompareTokens(before, lexer.tokens()));
+}
+
+TEST(LexerTest, incremental_random_edits_match_full_relex) {
+    string alphabet = "ab1.:=<> \n\";+end";
+    mt19937 random(12345);
+    IncrementalLexer lexer(generateLexerProgram(40));
+    for (int i = 0; i < 2000; i++) {
+        size_t offset = random() % (lexer.source().size() + 1);
+        size_t removed = min<size_t>(random() % 4, lexer.source().size() - offset);
+        string inserted(random() % 3, ' ');
+        for (char& c : inserted) c = alphabet[random() % alphabet.size()];
+        string before = lexer.source();
+        try {
+            lexer.apply({ offset, removed, inserted });
+        }
+        catch (const runtime_error&) {
+            EXPECT_EQ(lexer.source(), before);
+            continue;
+        }
+        ASSERT_TRUE(CompareTokens(Lexer(lexer.source()).tokenize(), lexer.tokens())) << i;
+    }
+}
+
+TEST(LexerTest, token_buffer_matches_tokens) {
+    vector<string> sources = {
+        generateLexerProgram(50),
+        "x := \"a\nb\" + \"c\";\n\ty := 1.5;\r\n  end.",
+        "a\n\n\n   b",
+        ""
+    };
+    for (const string& source : sources) {
+        Lexer lexer(source);
+        vector<Token> tokens = lexer.tokenize();
+        TokenBuffer buffer = lexer.tokenizeBuffer();
+        ASSERT_EQ(buffer.size(), tokens.size());
+        vector<Token> restored;
+        for (size_t i = 0; i < buffer.size(); i++) {
+            restored.push_back(buffer.token(i));
+        }
+        EXPECT_TRUE(CompareTokens(tokens, restored)) << source;
+    }
+}
+
+TEST(LexerTest, token_buffer_is_compact) {
+    Lexer lexer(generateLexerProgram(1000));
+    TokenBuffer buffer = lexer.tokenizeBuffer();
+    EXPECT_LE(buffer.bytes(), buffer.size() * 2 * (sizeof(uint8_t) + 2 * sizeof(uint32_t)));
+    EXPECT_LT(buffer.bytes() * 4, buffer.size() * sizeof(Token));
+}
+
+TEST(LexerTest, identifiers_are_interned) {
+    Lexer lexer("total := count + total * count; Write(other, total);");
+    vector<Token> tokens = lexer.tokenize();
+    shared_ptr<SymbolTable> symbols = lexer.symbols();
+    ASSERT_EQ(symbols->size(), 3);
+    EXPECT_EQ(symbols->name(0), "total");
+    EXPECT_EQ(symbols->name(1), "count");
+    EXPECT_EQ(symbols->name(2), "other");
+    for (const Token& token : tokens) {
+        if (token.type == TokenTypes::IDENTIFIER) {
+            EXPECT_EQ(symbols->name(token.symbol), token.value);
+            EXPECT_EQ(token.hash, SymbolTable::hashOf(token.value));
+        }
+        else {
+            EXPECT_EQ(token.symbol, NO_SYMBOL);
+        }
+    }
+    EXPECT_EQ(tokens[0].symbol, tokens[4].symbol);
+    EXPECT_EQ(symbols->find("count"), 1);
+    EXPECT_EQ(symbols->find("Write"), NO_SYMBOL);
+}
+
+TEST(LexerTest, symbol_table_grows_without_losing_names) {
+    SymbolTable symbols;
+    for (int i = 0; i < 5000; i++) {
+        EXPECT_EQ(symbols.intern("name_" + to_string(i)), uint32_t(i));
+    }
+    for (int i = 0; i < 5000; i++) {
+        EXPECT_EQ(symbols.find("name_" + to_string(i)), uint32_t(i));
+        EXPECT_EQ(symbols.intern("name_" + to_string(i)), uint32_t(i));
+    }
+    EXPECT_EQ(symbols.size(), 5000);
+}
+
+TEST(LexerTest, parallel_and_buffered_tokens_keep_symbol_ids) {
+    string source = generateLexerProgram(20000);
+    for (int i = 0; i < 300; i++) {
+        source.insert(source.size() - 4, "    name_" + to_string(i) + " := 1;\n");
+    }
+    Lexer lexer(source);
+    vector<Token> sequential = lexer.tokenize();
+
+    Lexer parallelLexer(source);
+    vector<Token> parallel = parallelLexer.tokenizeParallel(4);
+    ASSERT_EQ(sequential.size(), parallel.size());
+    for (size_t i = 0; i < sequential.size(); i++) {
+        ASSERT_EQ(sequential[i].symbol, parallel[i].symbol) << i;
+    }
+    EXPECT_EQ(lexer.symbols()->size(), parallelLexer.symbols()->size());
+
+    TokenBuffer buffer = lexer.tokenizeBuffer();
+    for (size_t i = 0; i < buffer.size(); i++) {
+        ASSERT_EQ(buffer.token(i).symbol, sequential[i].symbol);
+        ASSERT_EQ(buffer.token(i).hash, sequential[i].hash);
+    }
+}
+
+TEST(LexerTest, numeric_literals_are_parsed_once) {
+    vector<Token> tokens = Lexer("x := 42 + 3.25 * 7. - 9007199254740993;").tokenize();
+    EXPECT_EQ(tokens[2].number, 42.0);
+    EXPECT_EQ(tokens[4].number, 3.25);
+    EXPECT_EQ(tokens[6].number, 7.0);
+    EXPECT_EQ(tokens[8].number, 9007199254740992.0);
+    EXPECT_EQ(tokens[0].number, 0.0);
+
+    Lexer bufferLexer("y := 0.5;");
+    TokenBuffer buffer = bufferLexer.tokenizeBuffer();
+    EXPECT_EQ(buffer.token(2).number, 0.5);
+}
+
+TEST(LexerTest, numeric_literal_overflow_is_reported) {
+    string huge(400, '9');
+    EXPECT_THROW(Lexer("x := " + huge + ";").tokenize(), runtime_error);
+    EXPECT_THROW(Lexer("x := " + huge + ".5;").tokenize(), runtime_error);
+    EXPECT_NO_THROW(Lexer("x := 0." + huge + ";").tokenize());
+}
@@ -582,3 +582,279 @@ TEST(ParserTest, handles_syntax_error_missing_semicolon_between_statements) {
         parser.parse();
         }, runtime_error);
 }
+
+TEST(ParserTest, streaming_parse_matches_vector_parse) {
+    string source = R"(program Stream;
+                       const
+                           Limit : integer = 10;
+                       var
+                           a, b : integer;
+                           s : string;
+                       begin
+                           Read(a);
+                           b := (a + Limit) * 2 div 3;
+                           if (b >= Limit) then
+                           begin
+                               Write("big: ", b);
+                           end
+                           else
+                               s := "small";
+                       end.)";
+    Parser vectorParser(tokenize(source));
+    auto expectedAst = vectorParser.parse();
+
+    Lexer lexer(source);
+    Parser streamParser(lexer);
+    EXPECT_TRUE(CompareAST(streamParser.parse(), expectedAst));
+}
+
+TEST(ParserTest, token_buffer_parse_matches_vector_parse) {
+    string source = R"(program Buffer;
+                       var
+                           a, b : integer;
+                           s : string;
+                       begin
+                           s := "two
+lines";
+                           b := (a + 1) * 2 div 3;
+                           if (b <> a) then
+                           begin
+                               Write("b = ", b);
+                           end
+                           else
+                               Read(a);
+                       end.)";
+    Parser vectorParser(tokenize(source));
+    auto expectedAst = vectorParser.parse();
+
+    Parser bufferParser(Lexer(source).tokenizeBuffer());
+    EXPECT_TRUE(CompareAST(bufferParser.parse(), expectedAst));
+}
+
+TEST(ParserTest, streaming_parse_reports_syntax_errors) {
+    Lexer lexer(R"(program MissingSemicolon;
+                   begin
+                       a := 1
+                       b := 2;
+                   end.)");
+    Parser parser(lexer);
+    EXPECT_THROW(parser.parse(), runtime_error);
+}
+
+TEST(ParserTest, handles_integer_constant_out_of_range) {
+    EXPECT_THROW({
+        Parser parser(tokenize(R"(program ErrorConstRange;
+                                  const
+                                    Big : integer = 3000000000;
+                                  begin
+                                  end.)"));
+        parser.parse();
+        }, runtime_error);
+}
+
+TEST(ParserTest, arena_program_keeps_blocks_contiguous) {
+    Parser parser(tokenize(R"(program Arena;
+                              const
+                                  Limit : integer = 10;
+                              var
+                                  a, b : integer;
+                              begin
+                                  a := Limit;
+                                  if (a > 1) then
+                                  begin
+                                      b := a - 1;
+                                      Write("b = ", b);
+                                  end
+                                  else
+                                      Read(b);
+                              end.)"));
+    Program program = parser.parseProgram();
+
+    EXPECT_EQ(program.name, "Arena");
+    ASSERT_EQ(program.constSection.size(), 1u);
+    ASSERT_EQ(program.varSection.size(), 1u);
+    ASSERT_EQ(program.body.size(), 2u);
+    EXPECT_EQ(static_cast<const VarStatement*>(program.varSection[0])->names[1].text, "b");
+
+    ASSERT_EQ(program.body[1]->type, Node::NodeType::IF_STATEMENT);
+    auto ifStatement = static_cast<const IfStatement*>(program.body[1]);
+    EXPECT_TRUE(ifStatement->thenBlock);
+    EXPECT_FALSE(ifStatement->elseBlock);
+    ASSERT_EQ(ifStatement->thenBranch.size(), 2u);
+    EXPECT_EQ(ifStatement->thenBranch[1]->type, Node::NodeType::WRITE_STATEMENT);
+    ASSERT_EQ(ifStatement->elseBranch.size(), 1u);
+    EXPECT_EQ(ifStatement->elseBranch[0]->type, Node::NodeType::READ_STATEMENT);
+    ASSERT_NE(ifStatement->condition, nullptr);
+    EXPECT_EQ(ifStatement->condition->op, TokenTypes::GREATER);
+}
+
+TEST(ParserTest, moved_arena_leaves_source_empty) {
+    Arena arena;
+    string_view text = arena.copy("kept");
+    Arena owner(move(arena));
+    EXPECT_EQ(arena.bytesReserved(), 0u);
+    EXPECT_EQ(arena.bytesUsed(), 0u);
+
+    // исходная арена заводит свой блок и не пишет в блок владельца
+    string_view other = arena.copy("new!");
+    EXPECT_EQ(text, "kept");
+    EXPECT_EQ(other, "new!");
+    EXPECT_GT(arena.bytesReserved(), 0u);
+
+    arena = move(owner);
+    EXPECT_EQ(arena.bytesUsed(), 4u);
+    EXPECT_EQ(owner.bytesReserved(), 0u);
+    EXPECT_EQ(text, "kept");
+}
+
+TEST(ParserTest, arena_program_converts_to_and_from_node_lists) {
+    string source = R"(program RoundTrip;
+                       const
+                           Pi : double = 3.14;
+                           Name : string = "pas";
+                       var
+                           a : integer;
+                       begin
+                           a := (a + 1) * 2;
+                           if (a <> 0) then
+                               if (a > 1) then Write(a, Name);
+                               else begin
+                                   Read(a);
+                               end
+                       end.)";
+    Parser listParser(tokenize(source));
+    auto expectedAst = listParser.parse();
+
+
+    Program lowered = ProgramLowering::fromNodes(expectedAst);
+    EXPECT_EQ(lowered.name, "RoundTrip");
+    EXPECT_EQ(lowered.constSection.size(), 2u);
+    EXPECT_EQ(lowered.varSection.size(), 1u);
+    ASSERT_EQ(lowered.body.size(), 2u);
+    auto assign = static_cast<const AssignStatement*>(lowered.body[0]);
+    ASSERT_NE(assign->value, nullptr);
+    EXPECT_EQ(assign->value->op, TokenTypes::MULTIPLY);
+    auto inner = static_cast<const IfStatement*>(static_cast<const IfStatement*>(lowered.body[1])->thenBranch[0]);
+    EXPECT_TRUE(inner->elseBlock);
+    EXPECT_EQ(inner->elseBranch[0]->type, Node::NodeType::READ_STATEMENT);
+}
+
+// дерево выражения в скобочной записи: (a + (2 * b))
+string printExpr(const Expr* expr) {
+    switch (expr->kind) {
+    case ExpressionKind::LITERAL: {
+        const Value& value = static_cast<const LiteralExpr*>(expr)->value;
+        return value.type() == ValueType::STRING ? "\"" + string(value.text()) + "\"" : to_string(int(value.number()));
+    }
+    case ExpressionKind::IDENTIFIER:
+        return string(static_cast<const IdentifierExpr*>(expr)->name.text);
+    case ExpressionKind::NEGATE:
+        return "-" + printExpr(static_cast<const UnaryExpr*>(expr)->operand);
+    default: {
+        auto binary = static_cast<const BinaryExpr*>(expr);
+        static const map<TokenTypes, string> names = {
+            { TokenTypes::PLUS, "+" }, { TokenTypes::MINUS, "-" }, { TokenTypes::MULTIPLY, "*" }, { TokenTypes::DIVIDE, "/" },
+            { TokenTypes::KEYWORD_DIV, "div" }, { TokenTypes::KEYWORD_MOD, "mod" }, { TokenTypes::EQUAL, "=" }, { TokenTypes::LESS, "<" }
+        };
+        return "(" + printExpr(binary->left) + " " + names.at(binary->op) + " " + printExpr(binary->right) + ")";
+    }
+    }
+}
+
+TEST(ParserTest, expressions_are_parsed_into_trees) {
+    Parser parser(tokenize(R"(program Trees;
+                              begin
+                                  a := 1 - 2 - 3 * b div -c;
+                                  a := (1 - 2) * -(3 + b) mod 4;
+                                  Write("x = ", x + 1, s + "!");
+                                  if (a * 2 < b - 1) then Read(a);
+                              end.)"));
+    Program program = parser.parseProgram();
+    ASSERT_EQ(program.body.size(), 4u);
+
+    auto first = static_cast<const AssignStatement*>(program.body[0]);
+    EXPECT_TRUE(first->error.empty());
+    EXPECT_EQ(printExpr(first->value), "((1 - 2) - ((3 * b) div -c))");
+    EXPECT_TRUE(first->tokens.empty());
+
+    auto second = static_cast<const AssignStatement*>(program.body[1]);
+    EXPECT_EQ(printExpr(second->value), "(((1 - 2) * -(3 + b)) mod 4)");
+
+    auto write = static_cast<const WriteStatement*>(program.body[2]);
+    ASSERT_EQ(write->arguments.size(), 3u);
+    EXPECT_EQ(printExpr(write->arguments[0]), "\"x = \"");
+    EXPECT_EQ(printExpr(write->arguments[1]), "(x + 1)");
+    EXPECT_EQ(printExpr(write->arguments[2]), "(s + \"!\")");
+
+    auto ifStatement = static_cast<const IfStatement*>(program.body[3]);
+    EXPECT_EQ(ifStatement->condition->kind, ExpressionKind::COMPARISON);
+    EXPECT_EQ(printExpr(ifStatement->condition), "((a * 2) < (b - 1))");
+}
+
+TEST(ParserTest, malformed_expressions_are_kept_for_runtime) {
+    Parser parser(tokenize(R"(program Deferred;
+                              begin
+                                  a := (1 + 2;
+                                  Write(, a);
+                                  Write(a,, b);
+                                  Write(a, );
+                                  if (a) then Read(a);
+                                  if (a = 1 = 2) then Read(a);
+                                  a := 1 +;
+                              end.)"));
+    Program program = parser.parseProgram();
+    ASSERT_EQ(program.body.size(), 7u);
+    EXPECT_NE(static_cast<const AssignStatement*>(program.body[0])->error.find("parentheses"), string_view::npos);
+    EXPECT_NE(static_cast<const WriteStatement*>(program.body[1])->error.find("start with a comma"), string_view::npos);
+    EXPECT_NE(static_cast<const WriteStatement*>(program.body[2])->error.find("consecutive commas"), string_view::npos);
+    EXPECT_NE(static_cast<const WriteStatement*>(program.body[3])->error.find("end with a comma"), string_view::npos);
+    EXPECT_NE(static_cast<const IfStatement*>(program.body[4])->error.find("Must be comparison operator"), string_view::npos);
+    EXPECT_NE(static_cast<const IfStatement*>(program.body[5])->error.find("Multiple comparison operators"), string_view::npos);
+    EXPECT_NE(static_cast<const AssignStatement*>(program.body[6])->error.find("Failed to assign a"), string_view::npos);
+}
+
+TEST(ParserTest, node_cast_checks_node_kind) {
+    shared_ptr<Node> write = make_shared<WriteStatementNode>(vector<Token>{ Token(TokenTypes::INTEGER_LITERAL, "1") });
+    ASSERT_NE(nodeCast<WriteStatementNode>(write), nullptr);
+    EXPECT_EQ(nodeCast<WriteStatementNode>(write)->expression.size(), 1u);
+    EXPECT_EQ(nodeCast<ReadStatementNode>(write), nullptr);
+    EXPECT_EQ(nodeCast<IfStatementNode>(shared_ptr<Node>()), nullptr);
+}
+
+TEST(ParserTest, literals_are_compact_values) {
+    Parser parser(tokenize(R"(program Values;
+                              const
+                                  Name : string = "pas";
+                                  Half : double = 0.5;
+                              var
+                                  s : string;
+                                  a : double;
+                              begin
+                                  s := "pas";
+                                  a := 7 + 20000000000000000000;
+                              end.)"));
+    Program program = parser.parseProgram();
+    EXPECT_EQ(sizeof(Value), 16u);
+
+    const Value& name = static_cast<const ConstStatement*>(program.constSection[0])->value;
+    const Value& half = static_cast<const ConstStatement*>(program.constSection[1])->value;
+    EXPECT_EQ(name.type(), ValueType::STRING);
+    EXPECT_EQ(name.text(), "pas");
+    EXPECT_EQ(half.real(), 0.5);
+
+    const Value& literal = static_cast<const LiteralExpr*>(static_cast<const AssignStatement*>(program.body[0])->value)->value;
+    EXPECT_NE(literal.text().data(), name.text().data());
+    EXPECT_EQ(literal, name);
+    Value copy = name;
+    EXPECT_EQ(copy.text().data(), name.text().data());
+    EXPECT_NE(name, Value::fromText("pa"));
+    EXPECT_NE(half, Value::fromInteger(0));
+
+    auto sum = static_cast<const BinaryExpr*>(static_cast<const AssignStatement*>(program.body[1])->value);
+    const Value& small = static_cast<const LiteralExpr*>(sum->left)->value;
+    const Value& huge = static_cast<const LiteralExpr*>(sum->right)->value;
+    EXPECT_EQ(small.type(), ValueType::INTEGER);
+    EXPECT_EQ(small.integer(), 7);
+    EXPECT_EQ(huge.type(), ValueType::DOUBLE); // за пределами int64
+    EXPECT_EQ(huge.number(), 2e19);
+}
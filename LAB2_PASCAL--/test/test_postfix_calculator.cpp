@@ -204,4 +204,42 @@ TEST(PostfixCalculatorTest, calculates_complex_expression_with_unary_minus) {
     };
     map<string, double> operands;
     EXPECT_EQ(PostfixCalculator::Calculate(postfix, operands), -20.0);
-}
\ No newline at end of file
+}
+
+TEST(PostfixCalculatorTest, compiles_postfix_to_bytecode) {
+    vector<Token> postfix = {
+        { TokenTypes::IDENTIFIER, "x" },
+        { TokenTypes::INTEGER_LITERAL, "2" },
+        { TokenTypes::IDENTIFIER, "y" },
+        { TokenTypes::MINUS, "_" },
+        { TokenTypes::MULTIPLY, "*" },
+        { TokenTypes::IDENTIFIER, "x" },
+        { TokenTypes::KEYWORD_MOD, "mod" },
+        { TokenTypes::PLUS, "+" }
+    };
+    CompiledPostfix compiled = PostfixCalculator::Compile(postfix);
+    EXPECT_EQ(compiled.depth, 3);
+    EXPECT_EQ(compiled.operands, vector<string>({ "x", "y" }));
+    EXPECT_EQ(compiled.code.size(), 5 + 9 + 5 + 1 + 1 + 5 + 1 + 1 + 1);
+
+    double values[] = { 7, 1.5 };
+    double stack[3];
+    EXPECT_EQ(PostfixCalculator::Run(compiled, values, stack), 7 + fmod(2 * -1.5, 7));
+    values[0] = 10;
+    EXPECT_EQ(PostfixCalculator::Run(compiled, values), 10 + fmod(2 * -1.5, 10));
+}
+
+TEST(PostfixCalculatorTest, compile_rejects_malformed_postfix) {
+    EXPECT_THROW(PostfixCalculator::Compile({ { TokenTypes::PLUS, "+" } }), runtime_error);
+    EXPECT_THROW(PostfixCalculator::Compile({ { TokenTypes::MINUS, "_" } }), runtime_error);
+    EXPECT_THROW(PostfixCalculator::Compile({ { TokenTypes::IDENTIFIER, "a" }, { TokenTypes::IDENTIFIER, "b" } }), runtime_error);
+    EXPECT_THROW(PostfixCalculator::Compile({}), runtime_error);
+}
+
+TEST(PostfixCalculatorTest, run_reports_division_by_zero) {
+    CompiledPostfix compiled = PostfixCalculator::Compile({ { TokenTypes::INTEGER_LITERAL, "1" }, { TokenTypes::IDENTIFIER, "z" }, { TokenTypes::KEYWORD_DIV, "div" } });
+    double values[] = { 0 };
+    EXPECT_THROW(PostfixCalculator::Run(compiled, values), runtime_error);
+    values[0] = 2;
+    EXPECT_EQ(PostfixCalculator::Run(compiled, values), 0.0);
+}